@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    BatchThroughput.cpp
+
+    Compares ChorusBatch against one ChorusAudioProcessor per stream, the way
+    the render service currently runs. Both sides process the same number of
+    short mono streams with the same settings. Throughput is reported as
+    streams x samples per second.
+
+    Usage: BatchThroughput [numStreams] [secondsPerStream] [blockSize]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Chorus/Source/PluginProcessor.h"
+#include "BenchmarkHelpers.h"
+
+namespace
+{
+    using namespace benchmark;
+
+    constexpr double sampleRate = 48000.0;
+
+    void fillInput (juce::AudioBuffer<float>& buffer, int stream, int offset)
+    {
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.setSample (0, i, (float) std::sin (0.01 * (stream + 1) + 0.05 * (offset + i)));
+    }
+
+    double runSeparateInstances (int numStreams, int samplesPerStream, int blockSize)
+    {
+        juce::AudioProcessor::BusesLayout mono;
+        mono.inputBuses.add (juce::AudioChannelSet::mono());
+        mono.outputBuses.add (juce::AudioChannelSet::mono());
+
+        std::vector<std::unique_ptr<ChorusAudioProcessor>> instances;
+
+        for (int s = 0; s < numStreams; ++s)
+        {
+            auto processor = std::make_unique<ChorusAudioProcessor>();
+            processor->setBusesLayout (mono);
+            processor->setAdaptiveQualityEnabled (false);
+            setParameter (processor->treeState, rateSliderId, 2.0f);
+            setParameter (processor->treeState, depthSliderId, 50.0f);
+            setParameter (processor->treeState, centerDelaySliderId, 20.0f);
+            setParameter (processor->treeState, feedbackSliderId, 30.0f);
+            setParameter (processor->treeState, mixSliderId, 50.0f);
+            processor->prepareToPlay (sampleRate, blockSize);
+            instances.push_back (std::move (processor));
+        }
+
+        juce::AudioBuffer<float> buffer (1, blockSize);
+        juce::MidiBuffer midi;
+
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (int s = 0; s < numStreams; ++s)
+        {
+            for (int offset = 0; offset < samplesPerStream; offset += blockSize)
+            {
+                fillInput (buffer, s, offset);
+                instances[(size_t) s]->processBlock (buffer, midi);
+            }
+        }
+
+        return (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    }
+
+    double runBatch (int numStreams, int samplesPerStream, int blockSize)
+    {
+        ChorusBatch<float> batch;
+        batch.prepare (sampleRate, blockSize, numStreams);
+        batch.setRate (2.0f);
+        batch.setDepth (0.5f);
+        batch.setCentreDelay (20.0f);
+        batch.setFeedback (0.3f);
+        batch.setMix (0.5f);
+        batch.setQuality (QualityGovernor::getQualityForTier (0));
+
+        juce::AudioBuffer<float> buffer (numStreams, blockSize);
+        juce::AudioBuffer<float> streamBuffer (1, blockSize);
+
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (int offset = 0; offset < samplesPerStream; offset += blockSize)
+        {
+            for (int s = 0; s < numStreams; ++s)
+            {
+                fillInput (streamBuffer, s, offset);
+                buffer.copyFrom (s, 0, streamBuffer, 0, 0, blockSize);
+            }
+
+            batch.process (buffer.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(), blockSize);
+        }
+
+        return (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto numStreams = argc > 1 ? juce::String (argv[1]).getIntValue() : 1024;
+    const auto seconds = argc > 2 ? juce::String (argv[2]).getDoubleValue() : 1.0;
+    const auto blockSize = argc > 3 ? juce::String (argv[3]).getIntValue() : 512;
+    const auto samplesPerStream = (int) (seconds * sampleRate) / blockSize * blockSize;
+    const auto totalSamples = (double) numStreams * samplesPerStream;
+
+    const auto separateSeconds = runSeparateInstances (numStreams, samplesPerStream, blockSize);
+    const auto batchSeconds = runBatch (numStreams, samplesPerStream, blockSize);
+
+    std::cout << "streams: " << numStreams << ", samples per stream: " << samplesPerStream
+              << ", block size: " << blockSize << std::endl;
+    std::cout << "separate instances: " << totalSamples / separateSeconds / 1.0e6 << " M stream-samples/s" << std::endl;
+    std::cout << "batch:              " << totalSamples / batchSeconds / 1.0e6 << " M stream-samples/s" << std::endl;
+    std::cout << "speed-up:           " << separateSeconds / batchSeconds << "x" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    BenchmarkHelpers.h
+
+    The pieces the benchmark programs share: summary statistics over a set of
+    timings, the column format they are printed in, and setting a parameter
+    to a value in its own units.
+
+    It only needs JUCE, so HostBenchmark, which doesn't build the plugin
+    sources, can use it too.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace benchmark
+{
+    struct Stats
+    {
+        double mean = 0, p50 = 0, p99 = 0, p999 = 0, maximum = 0;
+    };
+
+    /** Sorts values in place and summarises them. */
+    inline Stats getStats (std::vector<double>& values)
+    {
+        Stats stats;
+
+        if (values.empty())
+            return stats;
+
+        std::sort (values.begin(), values.end());
+
+        auto at = [&values] (double fraction)
+        {
+            return values[juce::jmin (values.size() - 1, (size_t) (fraction * (double) values.size()))];
+        };
+
+        stats.mean = std::accumulate (values.begin(), values.end(), 0.0) / (double) values.size();
+        stats.p50 = at (0.5);
+        stats.p99 = at (0.99);
+        stats.p999 = at (0.999);
+        stats.maximum = values.back();
+        return stats;
+    }
+
+    inline juce::String formatMicroseconds (double seconds, int width)
+    {
+        return juce::String (seconds * 1.0e6, 1).paddedLeft (' ', width);
+    }
+
+    /** Sets a parameter as the host would, from a value in its own range. */
+    inline void setParameter (juce::AudioProcessorValueTreeState& treeState, const juce::String& id, float value)
+    {
+        auto* parameter = treeState.getParameter (id);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+}
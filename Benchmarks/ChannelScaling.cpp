@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    ChannelScaling.cpp
+
+    Times processBlock on buses from mono up to 16 channels, once with every
+    channel on the audio thread and once with the channels spread across the
+    processor's worker pool, and prints the speedup. The pool has one worker
+    fewer than min (channels, cores), so the parallel column only differs on a
+    machine with more than one core.
+
+    Adaptive quality is off, so both runs use the same quality throughout.
+
+    Usage: ChannelScaling [blockSize] [seconds]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Chorus/Source/PluginProcessor.h"
+#include "BenchmarkHelpers.h"
+
+namespace
+{
+    using namespace benchmark;
+
+    constexpr double sampleRate = 48000.0;
+
+    /** Microseconds per block, the best of a few runs. */
+    double timeLayout (const juce::AudioChannelSet& channels, ChorusAudioProcessor::ParallelProcessing mode, int blockSize, double seconds)
+    {
+        ChorusAudioProcessor processor;
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channels);
+        layout.outputBuses.add (channels);
+
+        if (! processor.setBusesLayout (layout))
+            return -1.0;
+
+        processor.setAdaptiveQualityEnabled (false);
+        processor.setParallelProcessing (mode);
+        setParameter (processor.treeState, rateSliderId, 2.0f);
+        setParameter (processor.treeState, depthSliderId, 50.0f);
+        setParameter (processor.treeState, centerDelaySliderId, 20.0f);
+        setParameter (processor.treeState, feedbackSliderId, 30.0f);
+        setParameter (processor.treeState, mixSliderId, 50.0f);
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (channels.size(), blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random (1);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (channel, i, random.nextFloat() - 0.5f);
+
+        const auto numBlocks = juce::jmax (1, (int) (seconds * sampleRate / blockSize));
+        auto best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < 3; ++run)
+        {
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+
+            for (int block = 0; block < numBlocks; ++block)
+                processor.processBlock (buffer, midi);
+
+            best = juce::jmin (best, (juce::Time::getMillisecondCounterHiRes() - start) * 1000.0 / numBlocks);
+        }
+
+        return best;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto blockSize = argc > 1 ? juce::String (argv[1]).getIntValue() : 512;
+    const auto seconds = argc > 2 ? juce::String (argv[2]).getDoubleValue() : 5.0;
+
+    const std::pair<const char*, juce::AudioChannelSet> layouts[] = {
+        { "mono",        juce::AudioChannelSet::mono() },
+        { "stereo",      juce::AudioChannelSet::stereo() },
+        { "5.1",         juce::AudioChannelSet::create5point1() },
+        { "7.1",         juce::AudioChannelSet::create7point1() },
+        { "7.1.4",       juce::AudioChannelSet::create7point1point4() },
+        { "16 discrete", juce::AudioChannelSet::discreteChannels (ChorusAudioProcessor::maxNumChannels) }
+    };
+
+    std::cout << "block: " << blockSize << " samples at " << sampleRate << " Hz, "
+              << juce::SystemStats::getNumCpus() << " cores" << std::endl;
+    std::cout << "layout       channels  serial us  parallel us  speedup" << std::endl;
+
+    for (auto& layout : layouts)
+    {
+        const auto serial = timeLayout (layout.second, ChorusAudioProcessor::ParallelProcessing::never, blockSize, seconds);
+        const auto parallel = timeLayout (layout.second, ChorusAudioProcessor::ParallelProcessing::always, blockSize, seconds);
+
+        std::cout << juce::String (layout.first).paddedRight (' ', 13)
+                  << juce::String (layout.second.size()).paddedLeft (' ', 8)
+                  << juce::String (serial, 1).paddedLeft (' ', 11)
+                  << juce::String (parallel, 1).paddedLeft (' ', 13)
+                  << juce::String (serial / parallel, 2).paddedLeft (' ', 9) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,336 @@
+/*
+  ==============================================================================
+
+    HostBenchmark.cpp
+
+    Loads the built plugin the way a host does, through
+    juce::AudioPluginFormatManager, so the numbers include what the wrapper
+    adds on top of the processor: parameter changes crossing the VST3 or LV2
+    boundary, bus and buffer conversion, and state saving and loading.
+
+    For each plugin file it reports:
+      - the time to create an instance and to prepare it, for the first load
+        (which includes loading the module) and as the median of later ones
+      - the time to save and restore the plugin state
+      - callback times at each block size, and with a different block size on
+        every callback, with every parameter but bypass automated along its
+        own slow sine unless --no-automation is given
+
+    With no files given it runs the VST3 and the LV2 from this build.
+
+    Usage: HostBenchmark [options] [plugin files...]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "BenchmarkHelpers.h"
+
+namespace
+{
+    using namespace benchmark;
+
+    const char* const usage =
+        "Usage: HostBenchmark [options] [plugin files...]\n"
+        "\n"
+        "  -s, --seconds <s>         audio seconds processed per block size (default: 30)\n"
+        "  -b, --block-sizes <list>  comma separated (default: 32,64,128,256,512,1024)\n"
+        "  -r, --sample-rate <hz>    (default: 48000)\n"
+        "  -n, --instances <n>       instances created for the load timing (default: 10)\n"
+        "      --no-automation       leave the parameters alone while processing\n";
+
+    double secondsSince (juce::int64 startTicks)
+    {
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    //==============================================================================
+    /** Moves every parameter except bypass along its own slow sine, a few
+        times a second, the way automation lanes do.
+    */
+    class Automation
+    {
+    public:
+        Automation (juce::AudioPluginInstance& instance, double sampleRate)
+        {
+            const auto* bypass = instance.getBypassParameter();
+
+            for (auto* parameter : instance.getParameters())
+                if (parameter != bypass && parameter->isAutomatable())
+                    lanes.push_back ({ parameter, 0.1 + 0.07 * (double) lanes.size(), parameter->getValue() });
+
+            secondsPerSample = 1.0 / sampleRate;
+        }
+
+        void advance (int numSamples)
+        {
+            for (auto& lane : lanes)
+            {
+                const auto value = 0.5 + 0.45 * std::sin (juce::MathConstants<double>::twoPi * lane.frequency * time);
+                lane.parameter->setValue ((float) value);
+            }
+
+            time += numSamples * secondsPerSample;
+        }
+
+        void restore()
+        {
+            for (auto& lane : lanes)
+                lane.parameter->setValue (lane.initialValue);
+        }
+
+        size_t getNumLanes() const noexcept    { return lanes.size(); }
+
+    private:
+        struct Lane
+        {
+            juce::AudioProcessorParameter* parameter;
+            double frequency;
+            float initialValue;
+        };
+
+        std::vector<Lane> lanes;
+        double time = 0, secondsPerSample = 0;
+    };
+
+    //==============================================================================
+    struct Options
+    {
+        double seconds = 30.0, sampleRate = 48000.0;
+        juce::Array<int> blockSizes { 32, 64, 128, 256, 512, 1024 };
+        int numInstances = 10;
+        bool automate = true;
+    };
+
+    /** Times every callback for seconds of audio, at blockSize or, if
+        blockSize is 0, at a random size up to maxBlockSize each time.
+    */
+    std::vector<double> runCallbacks (juce::AudioPluginInstance& instance, const Options& options,
+                                      int blockSize, int maxBlockSize, double& audioSeconds)
+    {
+        const auto numChannels = juce::jmax (instance.getTotalNumInputChannels(), instance.getTotalNumOutputChannels());
+        juce::AudioBuffer<float> buffer (numChannels, maxBlockSize);
+        juce::MidiBuffer midi;
+        juce::Random random (1);
+        Automation automation (instance, options.sampleRate);
+
+        const auto totalSamples = (juce::int64) (options.seconds * options.sampleRate);
+        std::vector<double> callbackSeconds;
+        callbackSeconds.reserve ((size_t) (totalSamples / juce::jmax (1, blockSize > 0 ? blockSize : maxBlockSize / 2)) + 1);
+
+        juce::int64 position = 0;
+
+        while (position < totalSamples)
+        {
+            const auto n = blockSize > 0 ? blockSize : 1 + random.nextInt (maxBlockSize);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* samples = buffer.getWritePointer (channel);
+
+                for (int i = 0; i < n; ++i)
+                    samples[i] = 0.25f * (float) std::sin (0.01 * (double) (position + i) * (channel + 1));
+            }
+
+            juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), numChannels, n);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            if (options.automate)
+                automation.advance (n);
+
+            instance.processBlock (block, midi);
+            callbackSeconds.push_back (secondsSince (start));
+            position += n;
+        }
+
+        automation.restore();
+        audioSeconds = (double) position / options.sampleRate;
+        return callbackSeconds;
+    }
+
+    //==============================================================================
+    bool benchmarkFile (juce::AudioPluginFormatManager& formatManager, const juce::String& path, const Options& options)
+    {
+        juce::OwnedArray<juce::PluginDescription> descriptions;
+        juce::AudioPluginFormat* format = nullptr;
+
+        for (auto* candidate : formatManager.getFormats())
+        {
+            if (candidate->fileMightContainThisPluginType (path))
+            {
+                candidate->findAllTypesForFile (descriptions, path);
+
+                if (! descriptions.isEmpty())
+                {
+                    format = candidate;
+                    break;
+                }
+            }
+        }
+
+        if (format == nullptr)
+        {
+            std::cerr << "no plugin found in " << path << std::endl;
+            return false;
+        }
+
+        const auto& description = *descriptions.getFirst();
+        const auto maxBlockSize = options.blockSizes.isEmpty() ? 1024
+                                                               : *std::max_element (options.blockSizes.begin(), options.blockSizes.end());
+
+        std::cout << std::endl << description.pluginFormatName << ": " << description.name << " " << description.version
+                  << " (" << path << ")" << std::endl;
+
+        // Instantiation. The first load also loads the module, so it is shown
+        // on its own.
+        std::vector<double> createSeconds, prepareSeconds;
+        std::unique_ptr<juce::AudioPluginInstance> instance;
+
+        for (int i = 0; i < juce::jmax (1, options.numInstances); ++i)
+        {
+            juce::String error;
+            const auto createStart = juce::Time::getHighResolutionTicks();
+            instance = formatManager.createPluginInstance (description, options.sampleRate, maxBlockSize, error);
+            createSeconds.push_back (secondsSince (createStart));
+
+            if (instance == nullptr)
+            {
+                std::cerr << "can't create an instance: " << error << std::endl;
+                return false;
+            }
+
+            const auto prepareStart = juce::Time::getHighResolutionTicks();
+            instance->prepareToPlay (options.sampleRate, maxBlockSize);
+            prepareSeconds.push_back (secondsSince (prepareStart));
+
+            if (i + 1 < options.numInstances)
+            {
+                instance->releaseResources();
+                instance.reset();
+            }
+        }
+
+        const auto firstCreate = createSeconds.front();
+        const auto firstPrepare = prepareSeconds.front();
+        const auto later = (size_t) juce::jmin (1, (int) createSeconds.size() - 1);
+        std::vector<double> laterCreate (createSeconds.begin() + (long) later, createSeconds.end());
+        std::vector<double> laterPrepare (prepareSeconds.begin() + (long) later, prepareSeconds.end());
+
+        std::cout << "instantiate: first " << firstCreate * 1000.0 << " ms, then median " << getStats (laterCreate).p50 * 1000.0
+                  << " ms over " << laterCreate.size() << std::endl;
+        std::cout << "prepare:     first " << firstPrepare * 1000.0 << " ms, then median " << getStats (laterPrepare).p50 * 1000.0
+                  << " ms" << std::endl;
+
+        // State handling, the way a host saves and reopens a session.
+        std::vector<double> saveSeconds, restoreSeconds;
+        juce::MemoryBlock state;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            state.reset();
+            const auto saveStart = juce::Time::getHighResolutionTicks();
+            instance->getStateInformation (state);
+            saveSeconds.push_back (secondsSince (saveStart));
+
+            const auto restoreStart = juce::Time::getHighResolutionTicks();
+            instance->setStateInformation (state.getData(), (int) state.getSize());
+            restoreSeconds.push_back (secondsSince (restoreStart));
+        }
+
+        std::cout << "state:       " << state.getSize() << " bytes, save " << getStats (saveSeconds).p50 * 1.0e6
+                  << " us, restore " << getStats (restoreSeconds).p50 * 1.0e6 << " us (median of 100)" << std::endl;
+
+        // Callbacks.
+        std::cout << "automation:  " << (options.automate ? juce::String ((int) Automation (*instance, options.sampleRate).getNumLanes()) + " parameters"
+                                                          : juce::String ("off")) << std::endl;
+        std::cout << "block    mean us    p50 us    p99 us  p99.9 us    max us    load %" << std::endl;
+
+        auto blockSizes = options.blockSizes;
+        blockSizes.add (0);
+
+        for (auto blockSize : blockSizes)
+        {
+            // A second of audio first, so the caches and the adaptive quality
+            // governor have settled.
+            auto warmUp = options;
+            warmUp.seconds = 1.0;
+            double audioSeconds = 0;
+            runCallbacks (*instance, warmUp, blockSize, maxBlockSize, audioSeconds);
+
+            auto callbackSeconds = runCallbacks (*instance, options, blockSize, maxBlockSize, audioSeconds);
+            const auto total = std::accumulate (callbackSeconds.begin(), callbackSeconds.end(), 0.0);
+            const auto stats = getStats (callbackSeconds);
+
+            std::cout << (blockSize > 0 ? juce::String (blockSize) : juce::String ("vary")).paddedLeft (' ', 5)
+                      << formatMicroseconds (stats.mean, 11)
+                      << formatMicroseconds (stats.p50, 10)
+                      << formatMicroseconds (stats.p99, 10)
+                      << formatMicroseconds (stats.p999, 10)
+                      << formatMicroseconds (stats.maximum, 10)
+                      << juce::String (100.0 * total / audioSeconds, 2).paddedLeft (' ', 10) << std::endl;
+        }
+
+        instance->releaseResources();
+        return true;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    Options options;
+    const auto secondsOption = arguments.removeValueForOption ("--seconds|-s");
+    const auto blockSizesOption = arguments.removeValueForOption ("--block-sizes|-b");
+    const auto sampleRateOption = arguments.removeValueForOption ("--sample-rate|-r");
+    const auto instancesOption = arguments.removeValueForOption ("--instances|-n");
+    options.automate = ! arguments.removeOptionIfFound ("--no-automation");
+
+    if (secondsOption.isNotEmpty())     options.seconds = secondsOption.getDoubleValue();
+    if (sampleRateOption.isNotEmpty())  options.sampleRate = sampleRateOption.getDoubleValue();
+    if (instancesOption.isNotEmpty())   options.numInstances = instancesOption.getIntValue();
+
+    if (blockSizesOption.isNotEmpty())
+    {
+        options.blockSizes.clear();
+
+        for (auto& size : juce::StringArray::fromTokens (blockSizesOption, ",", {}))
+            if (size.getIntValue() > 0)
+                options.blockSizes.add (size.getIntValue());
+    }
+
+    juce::StringArray paths;
+
+    for (auto& argument : arguments.arguments)
+        paths.add (juce::File::getCurrentWorkingDirectory().getChildFile (argument.text).getFullPathName());
+
+    if (paths.isEmpty())
+        paths.addArray ({ CHORUS_VST3_PATH, CHORUS_LV2_PATH });
+
+    if (options.seconds <= 0 || options.sampleRate <= 0 || options.blockSizes.isEmpty())
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    juce::AudioPluginFormatManager formatManager;
+    formatManager.addDefaultFormats();
+
+    std::cout << "sample rate: " << options.sampleRate << " Hz, " << options.seconds << " s of audio per block size" << std::endl;
+
+    auto allSucceeded = true;
+
+    for (auto& path : paths)
+        allSucceeded = benchmarkFile (formatManager, path, options) && allSucceeded;
+
+    return allSucceeded ? 0 : 1;
+}
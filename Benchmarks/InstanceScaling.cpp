@@ -0,0 +1,447 @@
+/*
+  ==============================================================================
+
+    InstanceScaling.cpp
+
+    Runs N ChorusAudioProcessor instances in one process, the way a large
+    session does, and shows how the cost grows with N. A simulated host
+    callback processes every instance once per period, with the instances
+    split across one or more host threads. A period ends when the last thread
+    finishes its share, like a host's audio callback.
+
+    For each instance count and thread count it reports:
+      - resident memory added per instance, once created and prepared
+      - the cores needed to keep up in real time: busy thread time over the
+        length of audio processed
+      - the last-level cache miss rate of the host threads, where perf allows
+      - the mean, p99 and worst callback times, and how many went over the
+        period's duration
+
+    Each instance has a stereo bus and its own settings. Adaptive quality is
+    off, so a regression shows up as time rather than as a quality step.
+
+    Usage: InstanceScaling [options]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Chorus/Source/PluginProcessor.h"
+#include "BenchmarkHelpers.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <malloc.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    using namespace benchmark;
+
+    const char* const usage =
+        "Usage: InstanceScaling [options]\n"
+        "\n"
+        "  -n, --instances <list>  instance counts, comma separated (default: 1,10,50,100,200,300,500)\n"
+        "  -t, --threads <list>    host thread counts, comma separated (default: 1)\n"
+        "  -b, --block-size <n>    (default: 128)\n"
+        "  -r, --sample-rate <hz>  (default: 48000)\n"
+        "  -s, --seconds <s>       audio seconds per run (default: 10)\n"
+        "      --adaptive          leave adaptive quality on\n";
+
+    /** The process's resident set in bytes, or -1 where it can't be read. */
+    juce::int64 getResidentBytes()
+    {
+       #if JUCE_LINUX
+        const auto fields = juce::StringArray::fromTokens (juce::File ("/proc/self/statm").loadFileAsString(), " ", {});
+
+        if (fields.size() > 1)
+            return fields[1].getLargeIntValue() * (juce::int64) sysconf (_SC_PAGESIZE);
+       #endif
+
+        return -1;
+    }
+
+    /** Hands memory freed by the previous run back to the system, so it isn't
+        reused by the next one and hidden from getResidentBytes().
+    */
+    void releaseFreedMemory()
+    {
+       #if JUCE_LINUX && defined (__GLIBC__)
+        malloc_trim (0);
+       #endif
+    }
+
+    //==============================================================================
+    /** Last-level cache references and misses of the calling thread, through
+        perf. Both read 0 if perf isn't available, e.g. in a container.
+    */
+    class CacheCounters
+    {
+    public:
+        CacheCounters()
+        {
+           #if JUCE_LINUX
+            references = open (PERF_COUNT_HW_CACHE_REFERENCES);
+            misses = open (PERF_COUNT_HW_CACHE_MISSES);
+           #endif
+        }
+
+        ~CacheCounters()
+        {
+           #if JUCE_LINUX
+            for (auto fd : { references, misses })
+                if (fd >= 0)
+                    close (fd);
+           #endif
+        }
+
+        bool isAvailable() const noexcept    { return references >= 0 && misses >= 0; }
+
+        juce::uint64 getReferences() const noexcept    { return read (references); }
+        juce::uint64 getMisses() const noexcept        { return read (misses); }
+
+    private:
+       #if JUCE_LINUX
+        static int open (juce::uint64 config)
+        {
+            perf_event_attr attributes {};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof (attributes);
+            attributes.config = config;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            return (int) syscall (SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+        }
+       #endif
+
+        static juce::uint64 read (int fd) noexcept
+        {
+            juce::uint64 count = 0;
+
+           #if JUCE_LINUX
+            if (fd >= 0 && ::read (fd, &count, sizeof (count)) != (ssize_t) sizeof (count))
+                count = 0;
+           #endif
+
+            return count;
+        }
+
+        int references = -1, misses = -1;
+    };
+
+    //==============================================================================
+    /** The instances and their buffers, and the threads that process them. The
+        calling thread is host thread 0 and takes the first share.
+    */
+    class SimulatedHost
+    {
+    public:
+        SimulatedHost (std::vector<std::unique_ptr<ChorusAudioProcessor>>& p, int numThreads, int blockSize)
+            : processors (p), input (2, blockSize)
+        {
+            for (int i = 0; i < blockSize; ++i)
+                for (int channel = 0; channel < 2; ++channel)
+                    input.setSample (channel, i, 0.25f * (float) std::sin (0.02 * i * (channel + 1)));
+
+            for (size_t i = 0; i < processors.size(); ++i)
+                buffers.emplace_back (2, blockSize);
+
+            for (int t = 0; t < numThreads; ++t)
+                shares.push_back (std::make_unique<Share> ((size_t) t * processors.size() / (size_t) numThreads,
+                                                           (size_t) (t + 1) * processors.size() / (size_t) numThreads));
+
+            for (int t = 1; t < numThreads; ++t)
+            {
+                threads.push_back (std::make_unique<HostThread> (*this, *shares[(size_t) t]));
+                threads.back()->startThread (juce::Thread::Priority::highest);
+            }
+        }
+
+        ~SimulatedHost()
+        {
+            for (auto& thread : threads)
+                thread->signalThreadShouldExit();
+
+            generation.fetch_add (1, std::memory_order_release);
+
+            for (auto& thread : threads)
+                thread->stopThread (2000);
+        }
+
+        /** Runs one period and returns how long it took, in seconds. */
+        double runPeriod()
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            sharesRemaining.store ((int) threads.size(), std::memory_order_relaxed);
+            generation.fetch_add (1, std::memory_order_release);
+
+            process (*shares[0]);
+
+            while (sharesRemaining.load (std::memory_order_acquire) > 0)
+                std::this_thread::yield();
+
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        }
+
+        //==============================================================================
+        struct Totals
+        {
+            double busySeconds = 0;
+            juce::uint64 cacheReferences = 0, cacheMisses = 0;
+            bool cacheCountersAvailable = true;
+        };
+
+        /** The sums over all host threads. Only call between periods. */
+        Totals getTotals() const
+        {
+            Totals totals;
+
+            for (auto& share : shares)
+            {
+                totals.busySeconds += share->busySeconds;
+                totals.cacheReferences += share->cacheReferences;
+                totals.cacheMisses += share->cacheMisses;
+                totals.cacheCountersAvailable = totals.cacheCountersAvailable && share->cacheCountersAvailable;
+            }
+
+            return totals;
+        }
+
+        void resetTotals()
+        {
+            for (auto& share : shares)
+            {
+                share->busySeconds = 0;
+                share->cacheReferences = 0;
+                share->cacheMisses = 0;
+            }
+        }
+
+    private:
+        /** A thread's instances, and the counts it has run up. Each is only
+            written by its own thread.
+        */
+        struct Share
+        {
+            Share (size_t first, size_t last) : begin (first), end (last) {}
+
+            const size_t begin, end;
+            double busySeconds = 0;
+            juce::uint64 cacheReferences = 0, cacheMisses = 0;
+            bool cacheCountersAvailable = false;
+            std::unique_ptr<CacheCounters> counters;
+            juce::MidiBuffer midi;
+        };
+
+        class HostThread  : public juce::Thread
+        {
+        public:
+            HostThread (SimulatedHost& h, Share& s)
+                : juce::Thread ("Simulated host thread"), host (h), share (s)
+            {
+            }
+
+            void run() override
+            {
+                auto lastGeneration = host.generation.load (std::memory_order_acquire);
+
+                while (! threadShouldExit())
+                {
+                    const auto current = host.generation.load (std::memory_order_acquire);
+
+                    if (current == lastGeneration)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    lastGeneration = current;
+
+                    if (threadShouldExit())
+                        break;
+
+                    host.process (share);
+                    host.sharesRemaining.fetch_sub (1, std::memory_order_acq_rel);
+                }
+            }
+
+        private:
+            SimulatedHost& host;
+            Share& share;
+        };
+
+        void process (Share& share)
+        {
+            // The counters count the thread that opens them, so each thread
+            // opens its own on its first period.
+            if (share.counters == nullptr)
+            {
+                share.counters = std::make_unique<CacheCounters>();
+                share.cacheCountersAvailable = share.counters->isAvailable();
+            }
+
+            const auto startReferences = share.counters->getReferences();
+            const auto startMisses = share.counters->getMisses();
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            for (auto i = share.begin; i < share.end; ++i)
+            {
+                auto& buffer = buffers[i];
+
+                for (int channel = 0; channel < 2; ++channel)
+                    buffer.copyFrom (channel, 0, input, channel, 0, buffer.getNumSamples());
+
+                processors[i]->processBlock (buffer, share.midi);
+            }
+
+            share.busySeconds += juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+            share.cacheReferences += share.counters->getReferences() - startReferences;
+            share.cacheMisses += share.counters->getMisses() - startMisses;
+        }
+
+        std::vector<std::unique_ptr<ChorusAudioProcessor>>& processors;
+        juce::AudioBuffer<float> input;
+        std::vector<juce::AudioBuffer<float>> buffers;
+
+        std::vector<std::unique_ptr<Share>> shares;
+        std::vector<std::unique_ptr<HostThread>> threads;
+        std::atomic<juce::uint32> generation { 0 };
+        std::atomic<int> sharesRemaining { 0 };
+    };
+
+    //==============================================================================
+    struct Options
+    {
+        int blockSize = 128;
+        double sampleRate = 48000.0, seconds = 10.0;
+        bool adaptive = false;
+    };
+
+    void runScenario (int numInstances, int numThreads, const Options& options)
+    {
+        releaseFreedMemory();
+        const auto residentBefore = getResidentBytes();
+
+        std::vector<std::unique_ptr<ChorusAudioProcessor>> processors;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto processor = std::make_unique<ChorusAudioProcessor>();
+            processor->setAdaptiveQualityEnabled (options.adaptive);
+            setParameter (processor->treeState, rateSliderId, (float) (1 + i % 20));
+            setParameter (processor->treeState, depthSliderId, (float) (20 + i % 60));
+            setParameter (processor->treeState, centerDelaySliderId, (float) (5 + i % 40));
+            setParameter (processor->treeState, feedbackSliderId, (float) (i % 50));
+            setParameter (processor->treeState, mixSliderId, 50.0f);
+            processor->prepareToPlay (options.sampleRate, options.blockSize);
+            processors.push_back (std::move (processor));
+        }
+
+        const auto residentAfter = getResidentBytes();
+
+        SimulatedHost host (processors, numThreads, options.blockSize);
+        const auto periodSeconds = options.blockSize / options.sampleRate;
+        const auto numPeriods = juce::jmax (1, (int) (options.seconds / periodSeconds));
+
+        // Half a second first, so caches, the branch predictor and the engine
+        // ramps have settled.
+        for (int i = 0; i < (int) (0.5 / periodSeconds); ++i)
+            host.runPeriod();
+
+        host.resetTotals();
+
+        std::vector<double> callbackSeconds;
+        callbackSeconds.reserve ((size_t) numPeriods);
+
+        for (int i = 0; i < numPeriods; ++i)
+            callbackSeconds.push_back (host.runPeriod());
+
+        const auto totals = host.getTotals();
+        const auto audioSeconds = numPeriods * periodSeconds;
+        const auto mean = std::accumulate (callbackSeconds.begin(), callbackSeconds.end(), 0.0) / numPeriods;
+        const auto numOverruns = std::count_if (callbackSeconds.begin(), callbackSeconds.end(), [periodSeconds] (double s) { return s > periodSeconds; });
+
+        std::sort (callbackSeconds.begin(), callbackSeconds.end());
+        const auto p99 = callbackSeconds[juce::jmin (callbackSeconds.size() - 1, (size_t) (0.99 * numPeriods))];
+
+        const auto memoryPerInstance = residentBefore >= 0 ? juce::String ((double) (residentAfter - residentBefore) / numInstances / 1024.0, 1)
+                                                           : juce::String ("n/a");
+        const auto missRate = totals.cacheCountersAvailable && totals.cacheReferences > 0
+                                ? juce::String (100.0 * (double) totals.cacheMisses / (double) totals.cacheReferences, 2)
+                                : juce::String ("n/a");
+
+        std::cout << juce::String (numInstances).paddedLeft (' ', 9)
+                  << juce::String (numThreads).paddedLeft (' ', 8)
+                  << memoryPerInstance.paddedLeft (' ', 10)
+                  << juce::String (totals.busySeconds / audioSeconds, 3).paddedLeft (' ', 8)
+                  << juce::String (totals.busySeconds * 1.0e6 / ((double) numPeriods * numInstances), 2).paddedLeft (' ', 12)
+                  << missRate.paddedLeft (' ', 8)
+                  << juce::String (mean * 1.0e6, 1).paddedLeft (' ', 10)
+                  << juce::String (p99 * 1.0e6, 1).paddedLeft (' ', 10)
+                  << juce::String (callbackSeconds.back() * 1.0e6, 1).paddedLeft (' ', 10)
+                  << juce::String ((int) numOverruns).paddedLeft (' ', 8) << std::endl;
+    }
+
+    juce::Array<int> parseCounts (const juce::String& text)
+    {
+        juce::Array<int> counts;
+
+        for (auto& item : juce::StringArray::fromTokens (text, ",", {}))
+            if (item.getIntValue() > 0)
+                counts.add (item.getIntValue());
+
+        return counts;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    Options options;
+    auto instancesOption = arguments.removeValueForOption ("--instances|-n");
+    auto threadsOption = arguments.removeValueForOption ("--threads|-t");
+    const auto blockSizeOption = arguments.removeValueForOption ("--block-size|-b");
+    const auto sampleRateOption = arguments.removeValueForOption ("--sample-rate|-r");
+    const auto secondsOption = arguments.removeValueForOption ("--seconds|-s");
+    options.adaptive = arguments.removeOptionIfFound ("--adaptive");
+
+    if (instancesOption.isEmpty())      instancesOption = "1,10,50,100,200,300,500";
+    if (threadsOption.isEmpty())        threadsOption = "1";
+    if (blockSizeOption.isNotEmpty())   options.blockSize = blockSizeOption.getIntValue();
+    if (sampleRateOption.isNotEmpty())  options.sampleRate = sampleRateOption.getDoubleValue();
+    if (secondsOption.isNotEmpty())     options.seconds = secondsOption.getDoubleValue();
+
+    const auto instanceCounts = parseCounts (instancesOption);
+    const auto threadCounts = parseCounts (threadsOption);
+
+    if (arguments.size() > 0 || instanceCounts.isEmpty() || threadCounts.isEmpty()
+         || options.blockSize < 1 || options.sampleRate <= 0 || options.seconds <= 0)
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    std::cout << "block: " << options.blockSize << " samples at " << options.sampleRate << " Hz ("
+              << options.blockSize / options.sampleRate * 1.0e6 << " us), " << options.seconds << " s per run, adaptive quality "
+              << (options.adaptive ? "on" : "off") << std::endl;
+    std::cout << "instances threads  KB/inst   cores  us/inst/cb  miss %   mean us    p99 us    max us  overrun" << std::endl;
+
+    for (auto numThreads : threadCounts)
+        for (auto numInstances : instanceCounts)
+            runScenario (numInstances, juce::jmin (numThreads, numInstances), options);
+
+    return 0;
+}
@@ -0,0 +1,596 @@
+/*
+  ==============================================================================
+
+    KernelBenchmarks.cpp
+
+    Times the stages of ChorusEngine one at a time, and the whole engine, over
+    a sweep of block sizes, sample rates and channel counts. Built with the
+    plugin, it also times ChorusAudioProcessor::processBlock.
+
+    Kernels:
+        lfo           generating a block of modulation
+        delayWrite    writing the input into the delay lines
+        readLinear    the voice taps with linear interpolation
+        readLagrange  the voice taps with 3rd-order Lagrange interpolation
+        mix           blending the wet signal into the dry one
+        parameters    a parameter change and the ramps it sets up
+        engine        ChorusEngine::process, including the copy from the input
+        processBlock  ChorusAudioProcessor::processBlock and the copy from the
+                      input, mono and stereo only
+
+    The results are written as JSON. nsPerSample is per sample of one channel
+    and nsPerFrame per sample of all channels, so kernels that don't depend on
+    the channel count (lfo, parameters) are best compared per frame. Cycles
+    come from the CPU's cycle counter through perf where the kernel allows it,
+    otherwise from the time stamp counter, which counts at a fixed rate rather
+    than the core clock. cycleCounter in the output says which one was used.
+
+    Usage: KernelBenchmarks [-o results.json] [--quick] [--kernels a,b,...]
+                            [--block-sizes 1,2,...] [--sample-rates 44100,...]
+                            [--channels 1,2,...] [--min-time ms] [--repetitions n]
+
+  ==============================================================================
+*/
+
+#if CHORUS_BENCHMARK_PROCESSOR
+ #include <JuceHeader.h>
+ #include "../Chorus/Source/PluginProcessor.h"
+#endif
+
+#include "ChorusEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+#if defined (__linux__)
+ #include <linux/perf_event.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+#if defined (__x86_64__) || defined (__i386__)
+ #include <x86intrin.h>
+ #define CHORUS_HAS_TSC 1
+#elif defined (_M_X64) || defined (_M_IX86)
+ #include <intrin.h>
+ #define CHORUS_HAS_TSC 1
+#endif
+
+#ifndef CHORUS_VERSION
+ #define CHORUS_VERSION "unknown"
+#endif
+
+namespace chorus
+{
+    /** Runs the private stages of a ChorusEngine on their own. */
+    struct KernelAccess
+    {
+        using Engine = ChorusEngine<float>;
+
+        static void generateModulation (Engine& engine, int n)    { engine.generateModulation (n); }
+        static void beginChunk (Engine& engine, int n)            { engine.beginChunk (n); }
+        static void endChunk (Engine& engine, int n)              { engine.endChunk (n); }
+
+        static void mixWet (Engine& engine, float* samples, const float* wet, int n)
+        {
+            engine.mixWet (samples, wet, n);
+        }
+
+        /** The tap reads of one channel, without the write, feedback or mix. */
+        static void readTaps (Engine& engine, int channel, const float* lfo, float* out, int n)
+        {
+            const auto* buffer = engine.delayBuffers.data() + channel * engine.bufferSize;
+            const auto msToSamples = (float) (engine.sampleRate / 1000.0);
+            auto position = engine.writePosition;
+
+            for (int i = 0; i < n; ++i)
+            {
+                out[i] = engine.sumVoices (buffer, position, i, engine.depth.at (i) * lfo[i], Engine::voiceDirections[channel & 1], msToSamples);
+                position = (position + 1) & engine.bufferMask;
+            }
+        }
+    };
+}
+
+namespace
+{
+    using Engine = chorus::ChorusEngine<float>;
+    using chorus::KernelAccess;
+
+    struct Case
+    {
+        std::string kernel;
+        int blockSize;
+        double sampleRate;
+        int numChannels;
+    };
+
+    struct Result
+    {
+        double nsPerFrame, minNsPerFrame, cyclesPerFrame;
+        long long framesTimed;
+    };
+
+    //==============================================================================
+    /** The core's cycle count through perf, or the time stamp counter where perf
+        isn't available, e.g. in a container or with perf_event_paranoid at 3.
+    */
+    class CycleCounter
+    {
+    public:
+        CycleCounter()
+        {
+           #if defined (__linux__)
+            perf_event_attr attributes {};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof (attributes);
+            attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            fd = (int) syscall (SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+           #endif
+        }
+
+        ~CycleCounter()
+        {
+           #if defined (__linux__)
+            if (fd >= 0)
+                close (fd);
+           #endif
+        }
+
+        const char* getSource() const noexcept
+        {
+            if (fd >= 0)
+                return "perf";
+
+           #if CHORUS_HAS_TSC
+            return "tsc";
+           #else
+            return "none";
+           #endif
+        }
+
+        bool isAvailable() const noexcept    { return std::string (getSource()) != "none"; }
+
+        unsigned long long read() const noexcept
+        {
+           #if defined (__linux__)
+            if (fd >= 0)
+            {
+                unsigned long long count = 0;
+
+                if (::read (fd, &count, sizeof (count)) == (ssize_t) sizeof (count))
+                    return count;
+            }
+           #endif
+
+           #if CHORUS_HAS_TSC
+            return (unsigned long long) __rdtsc();
+           #else
+            return 0;
+           #endif
+        }
+
+    private:
+        int fd = -1;
+    };
+
+    //==============================================================================
+    /** The engine and buffers for one case. The input is white noise, and the
+        engine runs at typical settings with the default quality.
+    */
+    struct Fixture
+    {
+        explicit Fixture (const Case& c)
+            : blockSize (c.blockSize), numChannels (c.numChannels)
+        {
+            engine.prepare (c.sampleRate, blockSize, numChannels);
+            engine.setParameters (settings[0]);
+            engine.reset();
+
+            std::minstd_rand random (1);
+            std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+            channels.resize ((size_t) numChannels);
+
+            for (auto& channel : channels)
+            {
+                channel.resize ((size_t) blockSize);
+
+                for (auto& sample : channel)
+                    sample = noise (random);
+
+                pointers.push_back (channel.data());
+            }
+
+            // The engine processes in place, so it reads from a copy that stays
+            // noise rather than decaying into denormals block after block.
+            inputs = channels;
+
+            for (auto& input : inputs)
+                inputPointers.push_back (input.data());
+
+            wet.resize ((size_t) blockSize);
+            lfo.resize ((size_t) blockSize);
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                wet[(size_t) i] = noise (random);
+                lfo[(size_t) i] = (float) std::sin (chorus::twoPi * i / 4096.0);
+            }
+
+            // Fill the delay lines so the taps read real audio.
+            for (int written = 0; written < (int) c.sampleRate / 4; written += blockSize)
+                engine.pushBypassed (pointers.data(), numChannels, blockSize);
+        }
+
+        int blockSize, numChannels;
+        Engine engine;
+        std::vector<std::vector<float>> channels;
+        std::vector<std::vector<float>> inputs;
+        std::vector<float*> pointers;
+        std::vector<const float*> inputPointers;
+        std::vector<float> wet, lfo;
+        bool flip = false;
+
+        const chorus::ChorusParameters<float> settings[2] = { { 1.0f, 0.5f, 10.0f, 0.3f, 0.5f },
+                                                              { 1.5f, 0.4f, 12.0f, 0.2f, 0.6f } };
+    };
+
+   #if CHORUS_BENCHMARK_PROCESSOR
+    struct ProcessorFixture
+    {
+        explicit ProcessorFixture (const Case& c)
+            : input (c.numChannels, c.blockSize), buffer (c.numChannels, c.blockSize)
+        {
+            juce::AudioProcessor::BusesLayout layout;
+            const auto set = c.numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+            layout.inputBuses.add (set);
+            layout.outputBuses.add (set);
+
+            processor.setBusesLayout (layout);
+            processor.setAdaptiveQualityEnabled (false);
+            processor.prepareToPlay (c.sampleRate, c.blockSize);
+
+            juce::Random random (1);
+
+            for (int channel = 0; channel < c.numChannels; ++channel)
+                for (int i = 0; i < c.blockSize; ++i)
+                    input.setSample (channel, i, random.nextFloat() - 0.5f);
+        }
+
+        void process()
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.copyFrom (channel, 0, input, channel, 0, buffer.getNumSamples());
+
+            processor.processBlock (buffer, midi);
+        }
+
+        ChorusAudioProcessor processor;
+        juce::AudioBuffer<float> input, buffer;
+        juce::MidiBuffer midi;
+    };
+   #endif
+
+    //==============================================================================
+    /** Returns a function that processes one block of the case, or an empty one
+        if the kernel doesn't exist or can't run this case.
+    */
+    std::function<void()> makeKernel (const Case& c, std::shared_ptr<void>& owner)
+    {
+        auto fixture = std::make_shared<Fixture> (c);
+        owner = fixture;
+        auto& f = *fixture;
+        auto& engine = f.engine;
+        const auto n = c.blockSize;
+
+        if (c.kernel == "lfo")
+            return [&engine, n] { KernelAccess::generateModulation (engine, n); KernelAccess::endChunk (engine, n); };
+
+        if (c.kernel == "delayWrite")
+            return [&f, n] { f.engine.pushBypassed (f.pointers.data(), f.numChannels, n); };
+
+        if (c.kernel == "readLinear" || c.kernel == "readLagrange")
+        {
+            chorus::ChorusQuality quality;
+            quality.interpolation = c.kernel == "readLinear" ? chorus::ChorusInterpolation::linear
+                                                             : chorus::ChorusInterpolation::lagrange3rd;
+            engine.setQuality (quality);
+
+            return [&f, n]
+            {
+                KernelAccess::beginChunk (f.engine, n);
+
+                for (int channel = 0; channel < f.numChannels; ++channel)
+                    KernelAccess::readTaps (f.engine, channel, f.lfo.data(), f.channels[(size_t) channel].data(), n);
+
+                KernelAccess::endChunk (f.engine, n);
+            };
+        }
+
+        if (c.kernel == "mix")
+        {
+            return [&f, n]
+            {
+                KernelAccess::beginChunk (f.engine, n);
+
+                for (int channel = 0; channel < f.numChannels; ++channel)
+                    KernelAccess::mixWet (f.engine, f.channels[(size_t) channel].data(), f.wet.data(), n);
+            };
+        }
+
+        if (c.kernel == "parameters")
+        {
+            return [&f, n]
+            {
+                f.flip = ! f.flip;
+                f.engine.setParameters (f.settings[f.flip ? 1 : 0]);
+                KernelAccess::beginChunk (f.engine, n);
+                KernelAccess::endChunk (f.engine, n);
+            };
+        }
+
+        if (c.kernel == "engine")
+            return [&f, n] { f.engine.process (f.inputPointers.data(), f.pointers.data(), f.numChannels, n); };
+
+       #if CHORUS_BENCHMARK_PROCESSOR
+        if (c.kernel == "processBlock" && c.numChannels <= 2)
+        {
+            auto processor = std::make_shared<ProcessorFixture> (c);
+            owner = processor;
+            return [&p = *processor] { p.process(); };
+        }
+       #endif
+
+        return {};
+    }
+
+    //==============================================================================
+    Result measure (const Case& c, const std::function<void()>& kernel, const CycleCounter& cycles,
+                    double minTimeSeconds, int repetitions)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto runBlocks = [&kernel] (long long numBlocks)
+        {
+            const auto start = Clock::now();
+
+            for (long long b = 0; b < numBlocks; ++b)
+                kernel();
+
+            return std::chrono::duration<double> (Clock::now() - start).count();
+        };
+
+        // Warm up, then find a block count that takes at least minTimeSeconds.
+        long long numBlocks = 1;
+
+        for (auto elapsed = runBlocks (numBlocks); elapsed < minTimeSeconds; elapsed = runBlocks (numBlocks))
+            numBlocks = elapsed > 0 ? std::max (numBlocks * 2, (long long) ((double) numBlocks * minTimeSeconds * 1.2 / elapsed))
+                                    : numBlocks * 2;
+
+        const auto framesPerRun = (double) numBlocks * c.blockSize;
+        std::vector<double> nsPerFrame, cyclesPerFrame;
+
+        for (int r = 0; r < repetitions; ++r)
+        {
+            const auto startCycles = cycles.read();
+            const auto seconds = runBlocks (numBlocks);
+            const auto endCycles = cycles.read();
+
+            nsPerFrame.push_back (seconds * 1.0e9 / framesPerRun);
+            cyclesPerFrame.push_back ((double) (endCycles - startCycles) / framesPerRun);
+        }
+
+        auto median = [] (std::vector<double> values)
+        {
+            std::sort (values.begin(), values.end());
+            return values[values.size() / 2];
+        };
+
+        return { median (nsPerFrame),
+                 *std::min_element (nsPerFrame.begin(), nsPerFrame.end()),
+                 median (cyclesPerFrame),
+                 (long long) framesPerRun * repetitions };
+    }
+
+    //==============================================================================
+    template <typename Type>
+    std::vector<Type> parseList (const std::string& text)
+    {
+        std::vector<Type> values;
+        std::stringstream stream (text);
+        std::string item;
+
+        while (std::getline (stream, item, ','))
+        {
+            std::stringstream itemStream (item);
+            Type value;
+
+            if (itemStream >> value)
+                values.push_back (value);
+        }
+
+        return values;
+    }
+
+    std::string getCpuName()
+    {
+        std::ifstream cpuInfo ("/proc/cpuinfo");
+        std::string line;
+
+        while (std::getline (cpuInfo, line))
+            if (line.rfind ("model name", 0) == 0 && line.find (':') != std::string::npos)
+                return line.substr (line.find (':') + 2);
+
+        return "unknown";
+    }
+
+    std::string escape (const std::string& text)
+    {
+        std::string escaped;
+
+        for (auto ch : text)
+        {
+            if (ch == '"' || ch == '\\')
+                escaped += '\\';
+
+            if ((unsigned char) ch >= 0x20)
+                escaped += ch;
+        }
+
+        return escaped;
+    }
+
+    std::string getTimestamp()
+    {
+        char text[32] = {};
+        const auto now = std::time (nullptr);
+        std::strftime (text, sizeof (text), "%Y-%m-%dT%H:%M:%SZ", std::gmtime (&now));
+        return text;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+   #if CHORUS_BENCHMARK_PROCESSOR
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    std::vector<std::string> kernels { "lfo", "delayWrite", "readLinear", "readLagrange", "mix", "parameters", "engine", "processBlock" };
+   #else
+    std::vector<std::string> kernels { "lfo", "delayWrite", "readLinear", "readLagrange", "mix", "parameters", "engine" };
+   #endif
+
+    std::vector<int> blockSizes { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    std::vector<double> sampleRates { 44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000 };
+    std::vector<int> channelCounts { 1, 2, 8 };
+    std::string outputPath;
+    double minTimeMs = 10.0;
+    int repetitions = 5;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string option (argv[i]);
+        const auto hasValue = i + 1 < argc;
+
+        if (option == "--quick")
+        {
+            blockSizes = { 64, 512, 4096 };
+            sampleRates = { 48000, 96000 };
+            channelCounts = { 2 };
+        }
+        else if (option == "-o" && hasValue)                { outputPath = argv[++i]; }
+        else if (option == "--kernels" && hasValue)         { kernels = parseList<std::string> (argv[++i]); }
+        else if (option == "--block-sizes" && hasValue)     { blockSizes = parseList<int> (argv[++i]); }
+        else if (option == "--sample-rates" && hasValue)    { sampleRates = parseList<double> (argv[++i]); }
+        else if (option == "--channels" && hasValue)        { channelCounts = parseList<int> (argv[++i]); }
+        else if (option == "--min-time" && hasValue)        { minTimeMs = std::atof (argv[++i]); }
+        else if (option == "--repetitions" && hasValue)     { repetitions = std::max (1, std::atoi (argv[++i])); }
+        else
+        {
+            std::cerr << "Usage: KernelBenchmarks [-o results.json] [--quick] [--kernels a,b,...] [--block-sizes 1,2,...]" << std::endl
+                      << "                        [--sample-rates 44100,...] [--channels 1,2,...] [--min-time ms] [--repetitions n]" << std::endl;
+            return 1;
+        }
+    }
+
+    const CycleCounter cycles;
+    std::ostringstream results;
+    results.precision (6);
+    bool first = true;
+
+    for (const auto& kernel : kernels)
+    {
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto numChannels : channelCounts)
+            {
+                for (auto blockSize : blockSizes)
+                {
+                    if (blockSize < 1 || numChannels < 1 || sampleRate <= 0)
+                        continue;
+
+                    const Case c { kernel, blockSize, sampleRate, numChannels };
+                    std::shared_ptr<void> owner;
+                    const auto run = makeKernel (c, owner);
+
+                    if (! run)
+                        continue;
+
+                    const auto result = measure (c, run, cycles, minTimeMs / 1000.0, repetitions);
+
+                    results << (first ? "" : ",") << "\n    { "
+                            << "\"kernel\": \"" << kernel << "\", "
+                            << "\"blockSize\": " << blockSize << ", "
+                            << "\"sampleRate\": " << sampleRate << ", "
+                            << "\"channels\": " << numChannels << ", "
+                            << "\"nsPerSample\": " << result.nsPerFrame / numChannels << ", "
+                            << "\"nsPerFrame\": " << result.nsPerFrame << ", "
+                            << "\"minNsPerFrame\": " << result.minNsPerFrame << ", ";
+
+                    if (cycles.isAvailable())
+                        results << "\"cyclesPerSample\": " << result.cyclesPerFrame / numChannels << ", "
+                                << "\"cyclesPerFrame\": " << result.cyclesPerFrame << ", ";
+                    else
+                        results << "\"cyclesPerSample\": null, \"cyclesPerFrame\": null, ";
+
+                    results << "\"framesTimed\": " << result.framesTimed << " }";
+                    first = false;
+
+                    std::cerr << kernel << " " << sampleRate << " Hz, " << numChannels << " ch, block " << blockSize
+                              << ": " << result.nsPerFrame / numChannels << " ns/sample" << std::endl;
+                }
+            }
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"benchmark\": \"KernelBenchmarks\",\n"
+         << "  \"version\": \"" << CHORUS_VERSION << "\",\n"
+         << "  \"timestamp\": \"" << getTimestamp() << "\",\n"
+         << "  \"cpu\": \"" << escape (getCpuName()) << "\",\n"
+        #if defined (__VERSION__)
+         << "  \"compiler\": \"" << escape (__VERSION__) << "\",\n"
+        #endif
+        #if defined (NDEBUG)
+         << "  \"assertions\": false,\n"
+        #else
+         << "  \"assertions\": true,\n"
+        #endif
+         << "  \"sampleType\": \"float\",\n"
+         << "  \"cycleCounter\": \"" << cycles.getSource() << "\",\n"
+         << "  \"minTimeMs\": " << minTimeMs << ",\n"
+         << "  \"repetitions\": " << repetitions << ",\n"
+         << "  \"results\": [" << results.str() << "\n  ]\n"
+         << "}\n";
+
+    if (outputPath.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file (outputPath);
+        file << json.str();
+
+        if (! file)
+        {
+            std::cerr << "can't write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
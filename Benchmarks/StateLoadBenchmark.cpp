@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    StateLoadBenchmark.cpp
+
+    Times a session restore: every instance is handed its saved state, once
+    as the binary format and once as the legacy ValueTree blob that older
+    builds saved. Saving is timed as well, and the size of both blobs is
+    printed.
+
+    Usage: StateLoadBenchmark [numInstances] [repeats]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Chorus/Source/PluginProcessor.h"
+#include "BenchmarkHelpers.h"
+
+namespace
+{
+    using namespace benchmark;
+
+    template <typename Fn>
+    double timeSeconds (int repeats, Fn&& fn)
+    {
+        auto best = std::numeric_limits<double>::max();
+
+        for (int r = 0; r < repeats; ++r)
+        {
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            fn();
+            best = juce::jmin (best, (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0);
+        }
+
+        return best;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto numInstances = argc > 1 ? juce::String (argv[1]).getIntValue() : 500;
+    const auto repeats = argc > 2 ? juce::String (argv[2]).getIntValue() : 5;
+
+    std::vector<std::unique_ptr<ChorusAudioProcessor>> instances;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        auto processor = std::make_unique<ChorusAudioProcessor>();
+        processor->prepareToPlay (48000.0, 512);
+        instances.push_back (std::move (processor));
+    }
+
+    // Each instance gets its own settings, as in a real session.
+    std::vector<juce::MemoryBlock> binaryStates, legacyStates;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        auto& processor = *instances[(size_t) i];
+        setParameter (processor.treeState, rateSliderId, (float) (1 + i % 99));
+        setParameter (processor.treeState, depthSliderId, (float) (i % 101));
+        setParameter (processor.treeState, mixSliderId, 50.0f);
+
+        juce::MemoryBlock binary;
+        processor.getStateInformation (binary);
+        binaryStates.push_back (std::move (binary));
+
+        juce::MemoryBlock legacy;
+        juce::MemoryOutputStream stream (legacy, false);
+        processor.treeState.copyState().writeToStream (stream);
+        stream.flush();
+        legacyStates.push_back (std::move (legacy));
+    }
+
+    auto restoreAll = [&] (const std::vector<juce::MemoryBlock>& states)
+    {
+        for (int i = 0; i < numInstances; ++i)
+            instances[(size_t) i]->setStateInformation (states[(size_t) i].getData(), (int) states[(size_t) i].getSize());
+    };
+
+    const auto binarySeconds = timeSeconds (repeats, [&] { restoreAll (binaryStates); });
+    const auto legacySeconds = timeSeconds (repeats, [&] { restoreAll (legacyStates); });
+
+    const auto saveSeconds = timeSeconds (repeats, [&]
+    {
+        juce::MemoryBlock block;
+
+        for (auto& processor : instances)
+        {
+            block.reset();
+            processor->getStateInformation (block);
+        }
+    });
+
+    std::cout << "instances: " << numInstances << ", best of " << repeats << std::endl;
+    std::cout << "binary state:   " << binaryStates[0].getSize() << " bytes, restore " << binarySeconds * 1000.0 << " ms" << std::endl;
+    std::cout << "legacy state:   " << legacyStates[0].getSize() << " bytes, restore " << legacySeconds * 1000.0 << " ms" << std::endl;
+    std::cout << "save (binary):  " << saveSeconds * 1000.0 << " ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+/*
+  ==============================================================================
+
+    TailLatency.cpp
+
+    Times every processBlock call of one ChorusAudioProcessor under the
+    conditions that cause dropouts rather than the ones that flatter the
+    average, and reports the tail: p99, p99.9 and the worst call.
+
+    Scenarios:
+        warm      callbacks back to back, as the baseline
+        cold      a buffer bigger than the last-level cache is walked before
+                  every callback, so the instance starts each one evicted
+        jumps     every parameter jumps to a random value every interval
+                  callbacks
+        reload    a different saved state is loaded every interval callbacks
+        prepare   the processor is released and prepared again every interval
+                  callbacks
+        all       cold, with jumps and reloads
+
+    Only the processBlock call itself is timed. The events happen between
+    callbacks, as they would on the message thread, and the callbacks right
+    after one are also reported on their own.
+
+    Usage: TailLatency [options]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Chorus/Source/PluginProcessor.h"
+#include "BenchmarkHelpers.h"
+
+namespace
+{
+    using namespace benchmark;
+
+    const char* const usage =
+        "Usage: TailLatency [options]\n"
+        "\n"
+        "  -s, --scenarios <list>  comma separated (default: warm,cold,jumps,reload,prepare,all)\n"
+        "  -n, --callbacks <n>     timed callbacks per scenario (default: 20000)\n"
+        "  -b, --block-size <n>    (default: 128)\n"
+        "  -r, --sample-rate <hz>  (default: 48000)\n"
+        "  -i, --interval <n>      callbacks between events (default: 16)\n"
+        "      --flush-mb <n>      size of the buffer walked between callbacks (default: 64)\n";
+
+    struct Options
+    {
+        int numCallbacks = 20000, blockSize = 128, interval = 16, flushMegabytes = 64;
+        double sampleRate = 48000.0;
+    };
+
+    struct Scenario
+    {
+        bool flush = false, jumps = false, reload = false, prepare = false;
+    };
+
+    bool getScenario (const juce::String& name, Scenario& scenario)
+    {
+        if (name == "warm")         scenario = {};
+        else if (name == "cold")    scenario = { true, false, false, false };
+        else if (name == "jumps")   scenario = { false, true, false, false };
+        else if (name == "reload")  scenario = { false, false, true, false };
+        else if (name == "prepare") scenario = { false, false, false, true };
+        else if (name == "all")     scenario = { true, true, true, false };
+        else                        return false;
+
+        return true;
+    }
+
+    //==============================================================================
+    /** Evicts whatever the last callback left in the caches by writing and
+        then reading a buffer several times their size, one cache line at a
+        time.
+    */
+    class CacheFlusher
+    {
+    public:
+        explicit CacheFlusher (int megabytes)
+            : lines ((size_t) juce::jmax (1, megabytes) * 1024 * 1024 / sizeof (Line))
+        {
+        }
+
+        void flush() noexcept
+        {
+            for (auto& line : lines)
+                line.value[0] += 1;
+
+            juce::uint64 sum = 0;
+
+            for (auto& line : lines)
+                sum += line.value[0];
+
+            sink = sum;
+        }
+
+    private:
+        struct alignas (64) Line
+        {
+            juce::uint64 value[8] = {};
+        };
+
+        std::vector<Line> lines;
+        volatile juce::uint64 sink = 0;
+    };
+
+    //==============================================================================
+    void randomiseParameters (ChorusAudioProcessor& processor, juce::Random& random)
+    {
+        for (auto* parameter : processor.getParameters())
+            parameter->setValue (random.nextFloat());
+    }
+
+    /** A few saved states with different settings, to switch between. */
+    std::vector<juce::MemoryBlock> makeStates (const Options& options)
+    {
+        ChorusAudioProcessor processor;
+        processor.prepareToPlay (options.sampleRate, options.blockSize);
+
+        juce::Random random (2);
+        std::vector<juce::MemoryBlock> states;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            randomiseParameters (processor, random);
+
+            juce::MemoryBlock state;
+            processor.getStateInformation (state);
+            states.push_back (std::move (state));
+        }
+
+        return states;
+    }
+
+    void runScenario (const juce::String& name, const Scenario& scenario, const Options& options,
+                      const std::vector<juce::MemoryBlock>& states, CacheFlusher& flusher)
+    {
+        ChorusAudioProcessor processor;
+        processor.setAdaptiveQualityEnabled (false);
+        processor.setStateInformation (states[0].getData(), (int) states[0].getSize());
+        processor.prepareToPlay (options.sampleRate, options.blockSize);
+
+        const auto numChannels = processor.getTotalNumOutputChannels();
+        juce::AudioBuffer<float> input (numChannels, options.blockSize), buffer (numChannels, options.blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random (1);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < options.blockSize; ++i)
+                input.setSample (channel, i, random.nextFloat() - 0.5f);
+
+        std::vector<double> allSeconds, afterEventSeconds;
+        allSeconds.reserve ((size_t) options.numCallbacks);
+
+        const auto numWarmUp = juce::jmax (1000, options.interval * 4);
+
+        for (int callback = -numWarmUp; callback < options.numCallbacks; ++callback)
+        {
+            const auto isEvent = callback % options.interval == options.interval - 1;
+
+            if (isEvent && scenario.jumps)
+                randomiseParameters (processor, random);
+
+            if (isEvent && scenario.reload)
+            {
+                const auto& state = states[(size_t) random.nextInt ((int) states.size())];
+                processor.setStateInformation (state.getData(), (int) state.getSize());
+            }
+
+            if (isEvent && scenario.prepare)
+            {
+                processor.releaseResources();
+                processor.prepareToPlay (options.sampleRate, options.blockSize);
+            }
+
+            if (scenario.flush)
+                flusher.flush();
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom (channel, 0, input, channel, 0, options.blockSize);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midi);
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+            if (callback < 0)
+                continue;
+
+            allSeconds.push_back (seconds);
+
+            if (isEvent && (scenario.jumps || scenario.reload || scenario.prepare))
+                afterEventSeconds.push_back (seconds);
+        }
+
+        const auto all = getStats (allSeconds);
+        const auto afterEvent = getStats (afterEventSeconds);
+        const auto budget = options.blockSize / options.sampleRate;
+
+        std::cout << name.paddedRight (' ', 8)
+                  << formatMicroseconds (all.mean, 9)
+                  << formatMicroseconds (all.p50, 9)
+                  << formatMicroseconds (all.p99, 9)
+                  << formatMicroseconds (all.p999, 10)
+                  << formatMicroseconds (all.maximum, 9)
+                  << juce::String (100.0 * all.maximum / budget, 1).paddedLeft (' ', 8)
+                  << (afterEventSeconds.empty() ? juce::String ("-").paddedLeft (' ', 14)
+                                                : formatMicroseconds (afterEvent.p99, 14))
+                  << (afterEventSeconds.empty() ? juce::String ("-").paddedLeft (' ', 14)
+                                                : formatMicroseconds (afterEvent.maximum, 14)) << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    Options options;
+    auto scenariosOption = arguments.removeValueForOption ("--scenarios|-s");
+    const auto callbacksOption = arguments.removeValueForOption ("--callbacks|-n");
+    const auto blockSizeOption = arguments.removeValueForOption ("--block-size|-b");
+    const auto sampleRateOption = arguments.removeValueForOption ("--sample-rate|-r");
+    const auto intervalOption = arguments.removeValueForOption ("--interval|-i");
+    const auto flushOption = arguments.removeValueForOption ("--flush-mb");
+
+    if (scenariosOption.isEmpty())      scenariosOption = "warm,cold,jumps,reload,prepare,all";
+    if (callbacksOption.isNotEmpty())   options.numCallbacks = callbacksOption.getIntValue();
+    if (blockSizeOption.isNotEmpty())   options.blockSize = blockSizeOption.getIntValue();
+    if (sampleRateOption.isNotEmpty())  options.sampleRate = sampleRateOption.getDoubleValue();
+    if (intervalOption.isNotEmpty())    options.interval = intervalOption.getIntValue();
+    if (flushOption.isNotEmpty())       options.flushMegabytes = flushOption.getIntValue();
+
+    const auto scenarioNames = juce::StringArray::fromTokens (scenariosOption, ",", {});
+    Scenario unused;
+
+    for (auto& name : scenarioNames)
+    {
+        if (! getScenario (name, unused))
+        {
+            std::cerr << "unknown scenario: " << name << std::endl << usage;
+            return 2;
+        }
+    }
+
+    if (arguments.size() > 0 || options.numCallbacks < 1 || options.blockSize < 1
+         || options.sampleRate <= 0 || options.interval < 1 || options.flushMegabytes < 1)
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    const auto states = makeStates (options);
+    CacheFlusher flusher (options.flushMegabytes);
+
+    std::cout << "block: " << options.blockSize << " samples at " << options.sampleRate << " Hz ("
+              << options.blockSize / options.sampleRate * 1.0e6 << " us), " << options.numCallbacks
+              << " callbacks, events every " << options.interval << std::endl;
+    std::cout << "scenario  mean us   p50 us   p99 us  p99.9 us   max us   max %  event p99 us  event max us" << std::endl;
+
+    for (auto& name : scenarioNames)
+    {
+        Scenario scenario;
+        getScenario (name, scenario);
+        runScenario (name, scenario, options, states, flusher);
+    }
+
+    return 0;
+}
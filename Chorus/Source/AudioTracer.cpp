@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    AudioTracer.cpp
+
+  ==============================================================================
+*/
+
+#include "AudioTracer.h"
+
+//==============================================================================
+AudioTracer::AudioTracer()
+    : juce::Thread ("Chorus trace writer")
+{
+}
+
+AudioTracer::~AudioTracer()
+{
+    stop();
+}
+
+bool AudioTracer::start (const juce::File& file)
+{
+    stop();
+
+    file.deleteFile();
+    auto newStream = std::make_unique<juce::FileOutputStream> (file);
+
+    if (newStream->failedToOpen())
+        return false;
+
+    stream = std::move (newStream);
+    slots.reset (new Slot[(size_t) capacity]);
+    writeIndex = 0;
+    readIndex = 0;
+    microsecondsPerTick = 1.0e6 / CycleClock::getTicksPerSecond();
+    originTicks = CycleClock::now();
+    isFirstEvent = true;
+    threads.clearQuick();
+    numDropped = 0;
+
+    *stream << "{\"traceEvents\":[\n";
+
+    tracing = true;
+    startThread();
+    return true;
+}
+
+void AudioTracer::stop()
+{
+    if (stream == nullptr)
+        return;
+
+    // A push that saw tracing still on finishes before the ring goes away.
+    tracing = false;
+
+    while (numWriters.load() != 0)
+        juce::Thread::yield();
+
+    stopThread (1000);
+    drain();
+
+    *stream << "\n],\n\"displayTimeUnit\":\"ns\",\n\"otherData\":{\"droppedEvents\":" << juce::String ((juce::uint64) getNumDropped()) << "}}\n";
+    stream.reset();
+    slots.reset();
+}
+
+//==============================================================================
+void AudioTracer::push (TraceStage stage, int channel, bool isBegin) noexcept
+{
+    if (! tracing.load (std::memory_order_relaxed))
+        return;
+
+    const auto ticks = CycleClock::now();
+
+    // Announced before tracing is checked again, so stop() either sees this
+    // writer and waits for it, or this writer sees tracing off and leaves the
+    // ring alone.
+    numWriters.fetch_add (1);
+
+    if (tracing.load())
+        record ({ ticks, juce::Thread::getCurrentThreadId(), channel, stage, isBegin });
+
+    numWriters.fetch_sub (1, std::memory_order_release);
+}
+
+void AudioTracer::record (const Event& event) noexcept
+{
+    auto index = writeIndex.load (std::memory_order_relaxed);
+
+    do
+    {
+        if (index - readIndex.load (std::memory_order_acquire) >= (uint64_t) capacity)
+        {
+            numDropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    while (! writeIndex.compare_exchange_weak (index, index + 1, std::memory_order_relaxed));
+
+    auto& slot = slots[(size_t) (index & (capacity - 1))];
+    slot.event = event;
+    slot.sequence.store (index + 1, std::memory_order_release);
+}
+
+void AudioTracer::run()
+{
+    while (! threadShouldExit())
+    {
+        drain();
+        wait (20);
+    }
+}
+
+void AudioTracer::drain()
+{
+    auto index = readIndex.load (std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& slot = slots[(size_t) (index & (capacity - 1))];
+
+        if (slot.sequence.load (std::memory_order_acquire) != index + 1)
+            break;
+
+        const auto event = slot.event;
+        readIndex.store (++index, std::memory_order_release);
+
+        if (event.ticks >= originTicks)
+            write (event);
+    }
+}
+
+void AudioTracer::write (const Event& event)
+{
+    const auto timestamp = (double) (event.ticks - originTicks) * microsecondsPerTick;
+
+    if (! isFirstEvent)
+        *stream << ",\n";
+
+    isFirstEvent = false;
+
+    *stream << "{\"name\":\"" << getTraceStageName (event.stage)
+            << "\",\"cat\":\"chorus\",\"ph\":\"" << (event.isBegin ? "B" : "E")
+            << "\",\"ts\":" << juce::String (timestamp, 3)
+            << ",\"pid\":1,\"tid\":" << getThreadIndex (event.thread);
+
+    if (event.channel >= 0)
+        *stream << ",\"args\":{\"channel\":" << event.channel << "}";
+
+    *stream << "}";
+}
+
+/** Small, stable numbers in the order threads first appear, which read
+    better in the viewer than raw thread handles.
+*/
+int AudioTracer::getThreadIndex (juce::Thread::ThreadID thread)
+{
+    auto index = threads.indexOf (thread);
+
+    if (index < 0)
+    {
+        index = threads.size();
+        threads.add (thread);
+    }
+
+    return index + 1;
+}
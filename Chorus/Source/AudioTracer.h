@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    AudioTracer.h
+
+    Records the trace points of one instance, the host callback and the
+    engine's stages, and writes them to a file as Chrome trace-event JSON,
+    which chrome://tracing and ui.perfetto.dev open directly.
+
+    The threads doing audio work push timestamped events into a fixed-size
+    ring without locking or allocating; a background thread drains it into
+    the file. Events that arrive while the ring is full are counted and
+    dropped. When tracing is off getSink() returns null, nothing is
+    recorded, and the ring isn't allocated at all, so an instance that is
+    never traced pays nothing for it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusEngine.h"
+#include "LoadMonitor.h"
+
+//==============================================================================
+class AudioTracer  : public TraceSink, private juce::Thread
+{
+public:
+    AudioTracer();
+    ~AudioTracer() override;
+
+    /** Starts a new trace in file, replacing anything already there, and
+        returns false if the file can't be written. Call from the message
+        thread.
+    */
+    bool start (const juce::File& file);
+
+    /** Writes out whatever is still buffered and closes the file. */
+    void stop();
+
+    bool isTracing() const noexcept    { return tracing.load (std::memory_order_relaxed); }
+
+    /** This tracer while a trace is running, otherwise null, so the result can
+        be handed straight to ScopedTrace or ChorusEngine::setTraceSink.
+    */
+    TraceSink* getSink() noexcept    { return isTracing() ? this : nullptr; }
+
+    /** Events lost to a full ring since the trace started. */
+    uint64_t getNumDropped() const noexcept    { return numDropped.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    void begin (TraceStage stage, int channel) noexcept override    { push (stage, channel, true); }
+    void end (TraceStage stage, int channel) noexcept override      { push (stage, channel, false); }
+
+    /** About two seconds of events at 64-sample blocks with four channels. */
+    static constexpr int capacity = 1 << 16;
+
+private:
+    //==============================================================================
+    struct Event
+    {
+        uint64_t ticks = 0;
+        juce::Thread::ThreadID thread = nullptr;
+        int channel = -1;
+        TraceStage stage = TraceStage::callback;
+        bool isBegin = false;
+    };
+
+    /** sequence is the event's index plus one once the event has been written,
+        so the reader can tell a finished slot from one still being filled or
+        left over from the previous lap.
+    */
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence { 0 };
+        Event event;
+    };
+
+    void push (TraceStage, int channel, bool isBegin) noexcept;
+    void record (const Event&) noexcept;
+    void run() override;
+    void drain();
+    void write (const Event&);
+    int getThreadIndex (juce::Thread::ThreadID);
+
+    /** Only allocated while a trace is running. */
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> writeIndex { 0 }, readIndex { 0 }, numDropped { 0 };
+    std::atomic<bool> tracing { false };
+
+    /** The pushes in progress, which stop() waits for before freeing slots. */
+    std::atomic<int> numWriters { 0 };
+
+    // Only touched by whichever thread is draining.
+    std::unique_ptr<juce::FileOutputStream> stream;
+    uint64_t originTicks = 0;
+    double microsecondsPerTick = 0;
+    bool isFirstEvent = true;
+    juce::Array<juce::Thread::ThreadID> threads;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioTracer)
+};
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    ChannelThreadPool.cpp
+
+  ==============================================================================
+*/
+
+#include "ChannelThreadPool.h"
+
+//==============================================================================
+class ChannelThreadPool::Worker  : public juce::Thread
+{
+public:
+    Worker (ChannelThreadPool& p, int index)
+        : juce::Thread ("Chorus channel worker " + juce::String (index)), pool (p)
+    {
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread (1000);
+    }
+
+    void wake()    { wakeUp.signal(); }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            while (pool.runNextGroup())
+                {}
+
+            // Blocks usually arrive back to back during a render, so spin for a
+            // moment before paying for a full sleep and wake-up. The event stays
+            // signalled until it is waited on, so a wake() that lands between
+            // the check and the wait isn't lost, and no timeout is needed.
+            const auto lastState = pool.state.load (std::memory_order_acquire);
+
+            for (int i = 0; i < spinIterations && pool.state.load (std::memory_order_acquire) == lastState; ++i)
+                std::this_thread::yield();
+
+            if (pool.state.load (std::memory_order_acquire) == lastState)
+                wakeUp.wait();
+        }
+    }
+
+private:
+    static constexpr int spinIterations = 200;
+
+    ChannelThreadPool& pool;
+    juce::WaitableEvent wakeUp;
+};
+
+//==============================================================================
+ChannelThreadPool::ChannelThreadPool (int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back (std::make_unique<Worker> (*this, i));
+
+    for (auto& worker : workers)
+        worker->startThread();
+}
+
+ChannelThreadPool::~ChannelThreadPool()
+{
+    workers.clear();
+}
+
+int ChannelThreadPool::chooseNumGroups (int numChannels, int numSamples) const noexcept
+{
+    const auto byWork = (numChannels * numSamples) / minSamplesPerGroup;
+    return juce::jmin (numChannels, getNumWorkers() + 1, byWork);
+}
+
+void ChannelThreadPool::run (const Job& job)
+{
+    currentJob.store (&job, std::memory_order_relaxed);
+    groupsRemaining.store (job.numGroups, std::memory_order_relaxed);
+    state.store (packState (++generation, job.numGroups, 0), std::memory_order_release);
+
+    for (int i = 0; i < juce::jmin (getNumWorkers(), job.numGroups - 1); ++i)
+        workers[(size_t) i]->wake();
+
+    while (runNextGroup())
+        {}
+
+    while (groupsRemaining.load (std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
+
+bool ChannelThreadPool::runNextGroup()
+{
+    auto current = state.load (std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto numGroups = (int) ((current >> 16) & 0xffff);
+        const auto group = (int) (current & 0xffff);
+
+        if (group >= numGroups)
+            return false;
+
+        if (state.compare_exchange_weak (current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            // Claiming a group means the job is still in flight, so the
+            // pointer can't be stale.
+            const auto* job = currentJob.load (std::memory_order_relaxed);
+            const auto first = group * job->numChannels / numGroups;
+            const auto last = (group + 1) * job->numChannels / numGroups;
+
+            job->invoke (job->context, first, last);
+            groupsRemaining.fetch_sub (1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    ChannelThreadPool.h
+
+    A small pool of worker threads that splits one block's channels into groups
+    and processes them in parallel, with the calling thread taking part.
+    Workers claim groups from a shared counter, so a worker that finishes early
+    takes the next unclaimed group instead of idling.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class ChannelThreadPool
+{
+public:
+    explicit ChannelThreadPool (int numWorkers);
+    ~ChannelThreadPool();
+
+    int getNumWorkers() const noexcept    { return (int) workers.size(); }
+
+    /** A group is only split off if it has at least this many channel-samples
+        of work, about 20 us at the default quality, which keeps the wake-up
+        cost well below the work it moves. A 5.1 bus at 512 samples makes three
+        groups.
+    */
+    static constexpr int minSamplesPerGroup = 1024;
+
+    //==============================================================================
+    /** Calls fn (firstChannel, lastChannel) for disjoint groups covering every
+        channel, and returns once all of them have finished. Small blocks are
+        run directly on the calling thread.
+    */
+    template <typename Fn>
+    void forEachChannelGroup (int numChannels, int numSamples, Fn&& fn)
+    {
+        const auto numGroups = chooseNumGroups (numChannels, numSamples);
+
+        if (numGroups <= 1)
+        {
+            fn (0, numChannels);
+            return;
+        }
+
+        using FnType = typename std::remove_reference<Fn>::type;
+
+        Job job;
+        job.context = &fn;
+        job.invoke = [] (void* context, int first, int last)    { (*static_cast<FnType*> (context)) (first, last); };
+        job.numChannels = numChannels;
+        job.numGroups = numGroups;
+
+        run (job);
+    }
+
+private:
+    //==============================================================================
+    struct Job
+    {
+        void* context = nullptr;
+        void (*invoke) (void*, int, int) = nullptr;
+        int numChannels = 0, numGroups = 0;
+    };
+
+    class Worker;
+
+    int chooseNumGroups (int numChannels, int numSamples) const noexcept;
+    void run (const Job&);
+    bool runNextGroup();
+
+    /** Packs the job generation, its group count and the next unclaimed group
+        into one word, so a worker can never claim a group of a job that has
+        already been replaced.
+    */
+    static uint64_t packState (uint32_t generation, int numGroups, int nextGroup) noexcept
+    {
+        return ((uint64_t) generation << 32) | ((uint64_t) (uint16_t) numGroups << 16) | (uint64_t) (uint16_t) nextGroup;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<const Job*> currentJob { nullptr };
+    std::atomic<uint64_t> state { 0 };
+    std::atomic<int> groupsRemaining { 0 };
+    uint32_t generation = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChannelThreadPool)
+};
@@ -0,0 +1,25 @@
+/*
+  ==============================================================================
+
+    ChorusEngine.h
+
+    Brings the DSP core in ChorusDSP/ into the plugin. The core is JUCE-free
+    and lives in namespace chorus; the plugin uses its types unqualified.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../ChorusDSP/ChorusDSP.h"
+
+using chorus::ChorusBatch;
+using chorus::ChorusEngine;
+using chorus::ChorusInterpolation;
+using chorus::ChorusParameters;
+using chorus::ChorusQuality;
+using chorus::LfoShape;
+using chorus::ScopedTrace;
+using chorus::TraceSink;
+using chorus::TraceStage;
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    ChorusState.cpp
+
+  ==============================================================================
+*/
+
+#include "ChorusState.h"
+
+//==============================================================================
+void ChorusState::writeTo (juce::MemoryBlock& destination) const
+{
+    juce::MemoryOutputStream payload (64);
+    payload.writeInt (numParameters);
+
+    for (auto value : values)
+        payload.writeFloat (value);
+
+    payload.writeInt (deterministic ? 1 : 0);
+    payload.writeInt (morphTarget);
+    payload.writeInt (program);
+
+    juce::MemoryOutputStream stream (destination, false);
+    stream.write ("CHST", 4);
+    stream.writeInt ((int) currentVersion);
+    stream.writeInt ((int) payload.getDataSize());
+    stream.write (payload.getData(), payload.getDataSize());
+    stream.writeInt ((int) hash (static_cast<const char*> (payload.getData()), payload.getDataSize()));
+}
+
+bool ChorusState::readFrom (const void* data, size_t size)
+{
+    constexpr size_t headerSize = 12, checksumSize = 4;
+    const auto* bytes = static_cast<const char*> (data);
+
+    if (size < headerSize + checksumSize || std::memcmp (bytes, "CHST", 4) != 0)
+        return false;
+
+    const auto version = juce::ByteOrder::littleEndianInt (bytes + 4);
+    const auto payloadSize = (size_t) juce::ByteOrder::littleEndianInt (bytes + 8);
+
+    if (version > currentVersion || payloadSize > size - headerSize - checksumSize)
+        return false;
+
+    const auto* payload = bytes + headerSize;
+
+    if (hash (payload, payloadSize) != juce::ByteOrder::littleEndianInt (payload + payloadSize))
+        return false;
+
+    auto readInt = [payload] (size_t offset)    { return juce::ByteOrder::littleEndianInt (payload + offset); };
+
+    if (payloadSize < 4)
+        return false;
+
+    const auto numStored = (size_t) readInt (0);
+
+    if (numStored > (payloadSize - 4) / 4 || payloadSize - 4 - numStored * 4 < 12)
+        return false;
+
+    for (size_t i = 0; i < juce::jmin (numStored, (size_t) numParameters); ++i)
+    {
+        const auto bits = readInt (4 + i * 4);
+        std::memcpy (&values[i], &bits, sizeof (float));
+    }
+
+    const auto tail = 4 + numStored * 4;
+    deterministic = (readInt (tail) & 1) != 0;
+    morphTarget = (int) readInt (tail + 4);
+    program = (int) readInt (tail + 8);
+    return true;
+}
+
+juce::uint32 ChorusState::hash (const char* data, size_t size) noexcept
+{
+    juce::uint32 h = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i)
+        h = (h ^ (juce::uint8) data[i]) * 16777619u;
+
+    return h;
+}
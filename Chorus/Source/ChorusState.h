@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    ChorusState.h
+
+    The plugin state as saved by the host. The layout is little-endian:
+
+        char[4]   "CHST"
+        uint32    version
+        uint32    payload size in bytes
+        payload:
+            uint32    number of parameter values, n
+            float[n]  parameter values, in the order of ChorusState::Parameter
+            uint32    flags (bit 0: deterministic rendering)
+            int32     morph target program
+            int32     current program
+        uint32    FNV-1a hash of the payload
+
+    A reader takes the parameter values it knows about and leaves the rest at
+    their defaults, so parameters can be appended without a version bump.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+struct ChorusState
+{
+    enum Parameter
+    {
+        rate,
+        depth,
+        centreDelay,
+        feedback,
+        mix,
+        morph,
+        numParameters
+    };
+
+    static constexpr juce::uint32 currentVersion = 1;
+
+    float values[numParameters] = {};
+    bool deterministic = false;
+    int morphTarget = 1;
+    int program = 0;
+
+    //==============================================================================
+    void writeTo (juce::MemoryBlock& destination) const;
+
+    /** Fills in the fields found in data. Returns false, with nothing changed,
+        if data isn't an intact state of a version this build can read, for
+        example a state saved by an older build as a ValueTree.
+    */
+    bool readFrom (const void* data, size_t size);
+
+private:
+    static juce::uint32 hash (const char* data, size_t size) noexcept;
+};
@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    EngineRebuilder.cpp
+
+  ==============================================================================
+*/
+
+#include "EngineRebuilder.h"
+
+namespace
+{
+    std::unique_ptr<juce::dsp::Oversampling<float>> createOversampler (int numChannels, int factor, int maxBlockSize)
+    {
+        auto oversampler = std::make_unique<juce::dsp::Oversampling<float>> ((size_t) numChannels,
+                                                                             (size_t) std::log2 (factor),
+                                                                             juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple,
+                                                                             true, true);
+        oversampler->initProcessing ((size_t) maxBlockSize);
+        return oversampler;
+    }
+}
+
+//==============================================================================
+EngineState::EngineState (const EngineLayout& newLayout)
+    : layout (newLayout)
+{
+    if (layout.oversamplingFactor > 1)
+        oversampler = createOversampler (layout.numOutputChannels, layout.oversamplingFactor, layout.maxBlockSize);
+
+    engine.prepare (layout.sampleRate * layout.oversamplingFactor,
+                    layout.maxBlockSize * layout.oversamplingFactor,
+                    layout.numChannels,
+                    layout.maxCentreDelayMs);
+    crossfadeBuffer.setSize (layout.numOutputChannels, layout.maxBlockSize);
+}
+
+int EngineState::getOfflineLatency() const noexcept
+{
+    return oversampler != nullptr ? juce::roundToInt (oversampler->getLatencyInSamples()) : 0;
+}
+
+int EngineState::getOfflineLatencyFor (const EngineLayout& layout)
+{
+    if (layout.oversamplingFactor <= 1)
+        return 0;
+
+    // The latency depends only on the factor and the filters, not on the
+    // channel count or block size.
+    return juce::roundToInt (createOversampler (1, layout.oversamplingFactor, 1)->getLatencyInSamples());
+}
+
+//==============================================================================
+class EngineRebuilder::BuildThread  : public juce::Thread
+{
+public:
+    explicit BuildThread (EngineRebuilder& r)
+        : juce::Thread ("Chorus engine builder"), rebuilder (r)
+    {
+    }
+
+    ~BuildThread() override
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread (2000);
+    }
+
+    void wake()    { wakeUp.signal(); }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            rebuilder.runPendingWork();
+            wakeUp.wait();
+        }
+    }
+
+private:
+    EngineRebuilder& rebuilder;
+    juce::WaitableEvent wakeUp;
+};
+
+//==============================================================================
+EngineRebuilder::EngineRebuilder() = default;
+
+EngineRebuilder::~EngineRebuilder()
+{
+    thread.reset();
+    delete builtState.exchange (nullptr);
+    delete retiredState.exchange (nullptr);
+}
+
+void EngineRebuilder::requestBuild (const EngineLayout& layout)
+{
+    {
+        const juce::ScopedLock sl (requestLock);
+        requestedLayout = layout;
+        buildRequested = true;
+        ++requestGeneration;
+    }
+
+    if (thread == nullptr)
+    {
+        thread = std::make_unique<BuildThread> (*this);
+        thread->startThread();
+    }
+
+    thread->wake();
+}
+
+void EngineRebuilder::cancelPending()
+{
+    const juce::ScopedLock sl (requestLock);
+    buildRequested = false;
+    ++requestGeneration;
+    delete builtState.exchange (nullptr);
+}
+
+void EngineRebuilder::freeRetiredState()
+{
+    delete retiredState.exchange (nullptr, std::memory_order_acquire);
+}
+
+void EngineRebuilder::runPendingWork()
+{
+    freeRetiredState();
+
+    EngineLayout layout;
+    uint32_t generation;
+
+    {
+        const juce::ScopedLock sl (requestLock);
+
+        if (! buildRequested)
+            return;
+
+        layout = requestedLayout;
+        generation = requestGeneration;
+        buildRequested = false;
+    }
+
+    auto state = std::make_unique<EngineState> (layout);
+
+    // A newer request or a cancel may have arrived while this one was being
+    // built, in which case it is stale and is dropped here.
+    const juce::ScopedLock sl (requestLock);
+
+    if (generation == requestGeneration)
+        delete builtState.exchange (state.release(), std::memory_order_acq_rel);
+}
+
+//==============================================================================
+EngineState* EngineRebuilder::takeBuiltState() noexcept
+{
+    if (retiredState.load (std::memory_order_acquire) != nullptr)
+        return nullptr;
+
+    return builtState.exchange (nullptr, std::memory_order_acq_rel);
+}
+
+void EngineRebuilder::retire (EngineState* state) noexcept
+{
+    jassert (retiredState.load (std::memory_order_relaxed) == nullptr);
+    retiredState.store (state, std::memory_order_release);
+}
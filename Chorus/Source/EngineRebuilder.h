@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    EngineRebuilder.h
+
+    Structural changes to the chorus (oversampling factor, delay line length)
+    need new buffers. EngineRebuilder allocates them on a background thread
+    and passes the finished EngineState to the audio thread through an atomic
+    pointer. The audio thread hands the state it replaced back the same way,
+    and the message thread frees it. The audio thread never allocates, frees
+    or waits.
+
+    Rebuilds are rare, so the thread is only started by the first request and
+    sleeps until the next one.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusEngine.h"
+
+//==============================================================================
+/** Everything needed to allocate an EngineState. */
+struct EngineLayout
+{
+    double sampleRate = 0;
+    int maxBlockSize = 0;
+
+    /** Delay lines, one per input. */
+    int numChannels = 1;
+
+    /** Channels the oversampler and crossfade buffer have to carry. */
+    int numOutputChannels = 1;
+
+    /** 1, 2, 4 or 8. Only applied while rendering offline. */
+    int oversamplingFactor = 1;
+
+    double maxCentreDelayMs = ChorusEngine<float>::maxCentreDelayMs;
+};
+
+/** The parts of the processor that are reallocated when the layout changes. */
+struct EngineState
+{
+    /** Allocates everything. Don't call this on the audio thread. */
+    explicit EngineState (const EngineLayout&);
+
+    /** The oversampling filter delay in host samples, or 0 if the state
+        doesn't oversample while rendering offline.
+    */
+    int getOfflineLatency() const noexcept;
+
+    /** What getOfflineLatency() will return for a state built from layout,
+        so the host can be told before the state exists. Allocates a
+        throwaway oversampler, so call it off the audio thread.
+    */
+    static int getOfflineLatencyFor (const EngineLayout& layout);
+
+    const EngineLayout layout;
+    ChorusEngine<float> engine;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+
+    /** Holds this state's copy of the block while it is crossfaded in. */
+    juce::AudioBuffer<float> crossfadeBuffer;
+
+    /** The engine's recovery count already added to the processor's total.
+        Only touched on the audio thread.
+    */
+    uint32_t countedRecoveries = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (EngineState)
+};
+
+//==============================================================================
+class EngineRebuilder
+{
+public:
+    EngineRebuilder();
+    ~EngineRebuilder();
+
+    /** Queues a new state to be built. If an earlier request hasn't finished,
+        only the latest is delivered. Call from the message thread.
+    */
+    void requestBuild (const EngineLayout& layout);
+
+    /** Throws away any queued or finished state that the audio thread hasn't
+        taken yet. Call this before replacing the state directly, e.g. in
+        prepareToPlay.
+    */
+    void cancelPending();
+
+    /** Frees the state the audio thread last retired, if there is one. Call
+        from the message thread, e.g. on a timer.
+    */
+    void freeRetiredState();
+
+    //==============================================================================
+    /** Audio thread: returns a finished state, which the caller now owns, or
+        nullptr. Nothing is returned until the last retired state has been
+        freed, so retire() always finds its slot empty. Wait-free.
+    */
+    EngineState* takeBuiltState() noexcept;
+
+    /** Audio thread: passes a state that is no longer used on to be freed by
+        freeRetiredState() or the next build. Wait-free.
+    */
+    void retire (EngineState* state) noexcept;
+
+private:
+    class BuildThread;
+
+    void runPendingWork();
+
+    std::unique_ptr<BuildThread> thread;
+
+    juce::CriticalSection requestLock;
+    EngineLayout requestedLayout;
+    bool buildRequested = false;
+    uint32_t requestGeneration = 0;
+
+    std::atomic<EngineState*> builtState { nullptr }, retiredState { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EngineRebuilder)
+};
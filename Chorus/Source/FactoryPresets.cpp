@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    FactoryPresets.cpp
+
+    The factory program bank, in the format PresetBank reads (see
+    PresetBank.h). Regenerate it with PresetBank::writeBank() after changing
+    the programs below.
+
+                         Rate  Depth Centre   Fdbk    Mix
+    Default                50      0     50      0      0
+    Subtle Width            1     20     12      0     35
+    Classic Chorus          2     45     20     10     50
+    Thick Ensemble          3     60     30     25     60
+    Slow Shimmer            1     80     25     40     45
+    Vibrato                 6     70      5      0    100
+    Flanger                 1     90      2     85     50
+    Seasick                 9    100     40     50     70
+
+  ==============================================================================
+*/
+
+#include "FactoryPresets.h"
+
+namespace FactoryPresets
+{
+
+static const unsigned char bankDataRaw[] =
+{
+    67,72,80,66,1,0,0,0,8,0,0,0,68,101,102,97,117,108,116,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,72,66,0,0,0,0,0,0,72,66,0,0,0,0,
+    0,0,0,0,83,117,98,116,108,101,32,87,105,100,116,104,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,128,63,
+    0,0,160,65,0,0,64,65,0,0,0,0,0,0,12,66,67,108,97,115,
+    115,105,99,32,67,104,111,114,117,115,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,64,0,0,52,66,0,0,160,65,
+    0,0,32,65,0,0,72,66,84,104,105,99,107,32,69,110,115,101,109,98,
+    108,101,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,64,64,0,0,112,66,0,0,240,65,0,0,200,65,0,0,112,66,
+    83,108,111,119,32,83,104,105,109,109,101,114,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,128,63,0,0,160,66,
+    0,0,200,65,0,0,32,66,0,0,52,66,86,105,98,114,97,116,111,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,192,64,0,0,140,66,0,0,160,64,0,0,0,0,
+    0,0,200,66,70,108,97,110,103,101,114,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,128,63,
+    0,0,180,66,0,0,0,64,0,0,170,66,0,0,72,66,83,101,97,115,
+    105,99,107,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,16,65,0,0,200,66,0,0,32,66,
+    0,0,72,66,0,0,140,66,
+};
+
+const char* bankData = (const char*) bankDataRaw;
+
+}
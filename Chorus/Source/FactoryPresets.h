@@ -0,0 +1,15 @@
+/*
+  ==============================================================================
+
+    FactoryPresets.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace FactoryPresets
+{
+    extern const char* bankData;
+    const int bankDataSize = 428;
+}
@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    LoadMonitor.h
+
+    Times every callback of one instance against its real-time budget, the
+    duration of the audio it was given, and keeps a histogram of the results.
+    The audio thread is the only writer and never waits; any thread can read
+    a snapshot. Measuring costs two reads of the CPU's cycle counter and a few
+    relaxed stores per callback.
+
+    The same measurement drives the QualityGovernor, so each callback is timed
+    once whether or not the histogram is being kept.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #include <x86intrin.h>
+#elif JUCE_INTEL && JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+//==============================================================================
+/** The cheapest monotonic tick count the CPU offers: the time stamp counter on
+    x86, the virtual counter on 64-bit ARM, and the high resolution timer
+    elsewhere.
+*/
+struct CycleClock
+{
+    static uint64_t now() noexcept
+    {
+       #if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG || JUCE_MSVC)
+        return (uint64_t) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+        uint64_t ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+        return ticks;
+       #else
+        return (uint64_t) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    /** Measured against the high resolution timer the first time it is
+        called, which takes a few milliseconds, so call it off the audio
+        thread first.
+    */
+    static double getTicksPerSecond() noexcept
+    {
+        static const auto ticksPerSecond = measureTicksPerSecond();
+        return ticksPerSecond;
+    }
+
+private:
+    static double measureTicksPerSecond() noexcept
+    {
+       #if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG || JUCE_MSVC)
+        const auto timerStart = juce::Time::getHighResolutionTicks();
+        const auto clockStart = now();
+        const auto timerTicks = juce::Time::getHighResolutionTicksPerSecond() / 200;
+        auto timerEnd = timerStart;
+
+        while (timerEnd - timerStart < timerTicks)
+            timerEnd = juce::Time::getHighResolutionTicks();
+
+        return (double) (now() - clockStart) / juce::Time::highResolutionTicksToSeconds (timerEnd - timerStart);
+       #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+        uint64_t frequency;
+        asm volatile ("mrs %0, cntfrq_el0" : "=r" (frequency));
+        return (double) frequency;
+       #else
+        return (double) juce::Time::getHighResolutionTicksPerSecond();
+       #endif
+    }
+};
+
+//==============================================================================
+class LoadMonitor
+{
+public:
+    /** Loads are binned in steps of 1/bucketsPerBudget of the budget up to
+        twice the budget, and the last bucket holds everything above that.
+    */
+    static constexpr int bucketsPerBudget = 32;
+    static constexpr int numBuckets = 2 * bucketsPerBudget + 1;
+
+    struct Snapshot
+    {
+        uint64_t counts[numBuckets] = {};
+        uint64_t numCallbacks = 0;
+
+        /** As fractions of the budget, so 1.0 is a callback that took as long
+            as the audio it produced.
+        */
+        double mean = 0, maximum = 0;
+
+        /** The upper edge of the bucket holding the given fraction of the
+            callbacks, so the result errs on the high side.
+        */
+        double getPercentile (double fraction) const noexcept
+        {
+            const auto target = (uint64_t) std::ceil (juce::jlimit (0.0, 1.0, fraction) * (double) numCallbacks);
+            uint64_t seen = 0;
+
+            for (int i = 0; i < numBuckets - 1; ++i)
+            {
+                seen += counts[i];
+
+                if (seen >= target && seen > 0)
+                    return juce::jmin (maximum, (double) (i + 1) / bucketsPerBudget);
+            }
+
+            return maximum;
+        }
+    };
+
+    //==============================================================================
+    /** Turns the histogram on or off. Callbacks are timed either way. */
+    void setEnabled (bool shouldBeEnabled) noexcept    { enabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept                    { return enabled; }
+
+    /** The load of the last callback measured, as a fraction of its budget.
+        Audio thread only.
+    */
+    double getLastLoad() const noexcept    { return lastLoad; }
+
+    /** Call before processing starts, off the audio thread. Clears the
+        histogram.
+    */
+    void prepare (double newSampleRate) noexcept
+    {
+        secondsPerTick = 1.0 / CycleClock::getTicksPerSecond();
+        sampleRate = newSampleRate;
+        lastLoad = 0;
+        clear();
+    }
+
+    /** Asks the audio thread to clear the histogram at its next callback. */
+    void reset() noexcept    { resetRequested = true; }
+
+    //==============================================================================
+    /** Times the rest of the enclosing scope as one callback of numSamples. */
+    class ScopedMeasurement
+    {
+    public:
+        ScopedMeasurement (LoadMonitor& m, int samples) noexcept
+            : monitor (m), numSamples (samples), startTicks (CycleClock::now())
+        {
+        }
+
+        ~ScopedMeasurement() noexcept
+        {
+            monitor.add (CycleClock::now() - startTicks, numSamples);
+        }
+
+    private:
+        LoadMonitor& monitor;
+        const int numSamples;
+        const uint64_t startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedMeasurement)
+    };
+
+    //==============================================================================
+    /** Safe to call from any thread. The fields are read one at a time, so a
+        snapshot taken mid-callback can be out by that one callback.
+    */
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+
+        for (int i = 0; i < numBuckets; ++i)
+            snapshot.counts[i] = counts[i].load (std::memory_order_relaxed);
+
+        snapshot.numCallbacks = numCallbacks.load (std::memory_order_relaxed);
+        snapshot.maximum = maximum.load (std::memory_order_relaxed);
+        snapshot.mean = snapshot.numCallbacks > 0 ? sum.load (std::memory_order_relaxed) / (double) snapshot.numCallbacks : 0.0;
+        return snapshot;
+    }
+
+private:
+    /** Only the audio thread writes, so plain loads and stores are enough and
+        no read-modify-write is needed.
+    */
+    void add (uint64_t elapsedTicks, int numSamples) noexcept
+    {
+        if (numSamples <= 0 || sampleRate <= 0)
+            return;
+
+        const auto load = (double) elapsedTicks * secondsPerTick * sampleRate / numSamples;
+        lastLoad = load;
+
+        if (! enabled.load (std::memory_order_relaxed))
+            return;
+
+        if (resetRequested.exchange (false, std::memory_order_relaxed))
+            clear();
+
+        const auto bucket = (int) (juce::jmin (load, 2.0) * bucketsPerBudget);
+
+        counts[bucket].store (counts[bucket].load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        numCallbacks.store (numCallbacks.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store (sum.load (std::memory_order_relaxed) + load, std::memory_order_relaxed);
+
+        if (load > maximum.load (std::memory_order_relaxed))
+            maximum.store (load, std::memory_order_relaxed);
+    }
+
+    void clear() noexcept
+    {
+        for (auto& count : counts)
+            count.store (0, std::memory_order_relaxed);
+
+        numCallbacks.store (0, std::memory_order_relaxed);
+        sum.store (0.0, std::memory_order_relaxed);
+        maximum.store (0.0, std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> enabled { true }, resetRequested { false };
+    double secondsPerTick = 0, sampleRate = 0, lastLoad = 0;
+
+    std::atomic<uint64_t> counts[numBuckets] {};
+    std::atomic<uint64_t> numCallbacks { 0 };
+    std::atomic<double> sum { 0.0 }, maximum { 0.0 };
+};
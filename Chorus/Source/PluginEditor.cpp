@@ -83,6 +83,12 @@ ChorusAudioProcessorEditor::ChorusAudioProcessorEditor (ChorusAudioProcessor& p)
     windowBorder.setText("Chorus");
     windowBorder.setColour(0x1005400, juce::Colour::fromFloatRGBA(1, 1, 1, 0.25f));
     windowBorder.setColour(0x1005410, juce::Colour::fromFloatRGBA(1, 1, 1, 0.25f));
+    
+    addAndMakeVisible(loadLabel);
+    loadLabel.setJustificationType(juce::Justification::centredRight);
+    loadLabel.setColour(0x1000281, juce::Colour::fromFloatRGBA(1, 1, 1, 0.25f));
+    timerCallback();
+    startTimerHz(4);
         
     //Making the window resizable by aspect ratio and setting size
     AudioProcessorEditor::setResizable(true, true);
@@ -95,6 +101,23 @@ ChorusAudioProcessorEditor::~ChorusAudioProcessorEditor()
 {
 }
 
+void ChorusAudioProcessorEditor::timerCallback()
+{
+    const auto load = audioProcessor.getLoadHistogram();
+    
+    if (! audioProcessor.isLoadMonitoringEnabled() || load.numCallbacks == 0)
+    {
+        loadLabel.setText("DSP load -", juce::dontSendNotification);
+        return;
+    }
+    
+    auto percent = [] (double fraction) { return juce::String(juce::roundToInt(fraction * 100.0)) + "%"; };
+    
+    loadLabel.setText("DSP load  avg " + percent(load.mean)
+                      + "  p99 " + percent(load.getPercentile(0.99))
+                      + "  max " + percent(load.maximum), juce::dontSendNotification);
+}
+
 //==============================================================================
 void ChorusAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -176,4 +199,6 @@ void ChorusAudioProcessorEditor::resized()
     /* ============================================================================ */
 
     windowBorder.setBounds(AudioProcessorEditor::getWidth() * .01, AudioProcessorEditor::getHeight() * 0.04, AudioProcessorEditor::getWidth() * .98, AudioProcessorEditor::getHeight() * .90);
+    loadLabel.setBounds(AudioProcessorEditor::getWidth() * .60, AudioProcessorEditor::getHeight() * 0.86, AudioProcessorEditor::getWidth() * .38, AudioProcessorEditor::getHeight() * .06);
+    loadLabel.setFont(juce::Font(AudioProcessorEditor::getHeight() * 0.045f));
 }
@@ -41,7 +41,7 @@ public:
     }
 };
 
-class ChorusAudioProcessorEditor  : public juce::AudioProcessorEditor
+class ChorusAudioProcessorEditor  : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     ChorusAudioProcessorEditor (ChorusAudioProcessor&);
@@ -53,6 +53,9 @@ public:
 
 private:
     
+    /** Refreshes the load readout from the processor's histogram. */
+    void timerCallback() override;
+    
     juce::Slider rateSlider, depthSlider, centerDelaySlider, feedbackSlider, mixSlider;
     std::vector<juce::Slider*> sliders;
     std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> rateSliderAttach, depthSliderAttach, centerDelaySliderAttach, feedbackSliderAttach, mixSliderAttach;
@@ -68,6 +71,8 @@ private:
     std::string feedbackSliderLabelText = "Feedback";
     std::string mixSliderLabelText = "Mix";
     std::vector<std::string> labelTexts;
+    
+    juce::Label loadLabel;
         
     ViatorDial customDial;
     juce::DropShadow shadowProperties;
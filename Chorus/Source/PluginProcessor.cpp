@@ -23,16 +23,28 @@ ChorusAudioProcessor::ChorusAudioProcessor()
 treeState (*this, nullptr, "PARAMETER", createParameterLayout())
 #endif
 {
+    engineLayout.oversamplingFactor = RenderProfile().oversamplingFactor;
+    
+   #if CHORUS_WITH_CLAP
+    for (auto* parameter : getParameters())
+        if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            clapParameters.push_back({ (clap_id) withId->paramID.hashCode(), parameter });
+   #endif
+    
+    // The audio thread can't notify the host or look up a shared clock, so
+    // the message thread polls for both.
+    startTimerHz(20);
 }
 
 ChorusAudioProcessor::~ChorusAudioProcessor()
 {
+    stopTimer();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout ChorusAudioProcessor::createParameterLayout()
 {
     std::vector <std::unique_ptr<juce::RangedAudioParameter>> params;
-    params.reserve(5);
+    params.reserve(6);
     
     
     auto rateParam = std::make_unique<juce::AudioParameterInt>(rateSliderId, rateSliderName, 1, 99, 50);
@@ -40,12 +52,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout ChorusAudioProcessor::create
     auto centerDelayParam = std::make_unique<juce::AudioParameterInt>(centerDelaySliderId, centerDelaySliderName, 1, 99, 50);
     auto feedbackParam = std::make_unique<juce::AudioParameterInt>(feedbackSliderId, feedbackSliderName, 0, 95, 0);
     auto mixParam = std::make_unique<juce::AudioParameterInt>(mixSliderId, mixSliderName, 0, 100, 0);
+    auto morphParam = std::make_unique<juce::AudioParameterInt>(morphSliderId, morphSliderName, 0, 100, 0);
 
     params.push_back(std::move(rateParam));
     params.push_back(std::move(depthParam));
     params.push_back(std::move(centerDelayParam));
     params.push_back(std::move(feedbackParam));
     params.push_back(std::move(mixParam));
+    params.push_back(std::move(morphParam));
     
     
     return { params.begin(), params.end() };
@@ -86,42 +100,281 @@ bool ChorusAudioProcessor::isMidiEffect() const
 
 double ChorusAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The longest tap, then one more trip round the loop for every pass the
+    // feedback takes to fall by 60 dB.
+    const auto depth = scaleRange(*treeState.getRawParameterValue(depthSliderId), 0, 100, 0.0f, 1.0f);
+    const auto feedback = scaleRange(*treeState.getRawParameterValue(feedbackSliderId), 0, 95, 0.0f, 0.95f);
+    const auto centreDelayMs = (double) *treeState.getRawParameterValue(centerDelaySliderId);
+    
+    const auto longestDelayMs = centreDelayMs * ChorusEngine<float>::maxVoiceSpread + depth * ChorusEngine<float>::maxModulationMs;
+    const auto passes = feedback > 0.0f ? std::ceil(std::log(0.001) / std::log((double) feedback)) : 0.0;
+    
+    return longestDelayMs * (1.0 + passes) / 1000.0;
 }
 
 int ChorusAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return presetBank.getNumPrograms();
 }
 
 int ChorusAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void ChorusAudioProcessor::setCurrentProgram (int index)
 {
+    // Hosts may call this from the audio thread, so all it does is flag the
+    // change. The next block picks up the program's snapshot directly.
+    if (! juce::isPositiveAndBelow(index, presetBank.getNumPrograms()))
+        return;
+    
+    currentProgram = index;
+    pendingProgram = index;
 }
 
 const juce::String ChorusAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presetBank.getProgramName(index);
 }
 
 void ChorusAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    // The bank is read-only: programs are renamed by editing the bank file.
+}
+
+bool ChorusAudioProcessor::loadUserPresetBank (const juce::File& bankFile)
+{
+    if (! presetBank.loadUserBank(bankFile, getProgramRanges()))
+        return false;
+    
+    updateHostDisplay();
+    return true;
+}
+
+PresetBank::Ranges ChorusAudioProcessor::getProgramRanges() const
+{
+    return { treeState.getParameterRange(rateSliderId), treeState.getParameterRange(depthSliderId),
+             treeState.getParameterRange(centerDelaySliderId), treeState.getParameterRange(feedbackSliderId),
+             treeState.getParameterRange(mixSliderId) };
+}
+
+void ChorusAudioProcessor::setMorphTarget (int programIndex)
+{
+    morphTarget = programIndex;
+    treeState.state.setProperty("morphTarget", programIndex, nullptr);
+}
+
+ParameterSnapshot ChorusAudioProcessor::getBlockParameters()
+{
+    const ScopedTrace parametersTrace(tracer.getSink(), TraceStage::parameters);
+    const auto program = pendingProgram.exchange(-1);
+    
+    // The timer copies the program into the parameters later; posting a
+    // message from here could lock or allocate.
+    if (program >= 0 && presetBank.getSnapshotOnAudioThread(program, programSnapshot))
+        programOverride = program;
+    
+    ParameterSnapshot parameters;
+    
+    if (programOverride >= 0)
+    {
+        parameters = programSnapshot;
+    }
+    else
+    {
+        parameters.rate = *treeState.getRawParameterValue(rateSliderId);
+        parameters.depth = *treeState.getRawParameterValue(depthSliderId);
+        parameters.centreDelay = *treeState.getRawParameterValue(centerDelaySliderId);
+        parameters.feedback = *treeState.getRawParameterValue(feedbackSliderId);
+        parameters.mix = *treeState.getRawParameterValue(mixSliderId);
+    }
+    
+    // The engine ramps every parameter across the block, so moving the morph
+    // amount interpolates between the two programs sample by sample.
+    const auto morph = scaleRange(*treeState.getRawParameterValue(morphSliderId), 0, 100, 0.0f, 1.0f);
+    ParameterSnapshot target;
+    
+    if (morph > 0 && presetBank.getSnapshotOnAudioThread(morphTarget, target))
+        parameters = ParameterSnapshot::interpolate(parameters, target, morph);
+    
+    return parameters;
+}
+
+void ChorusAudioProcessor::applyProgramOverride()
+{
+    // Bring the parameters, and with them the host and the editor, in line with
+    // the program the audio thread has already switched to.
+    const auto program = programOverride.load();
+    ParameterSnapshot snapshot;
+    
+    if (program < 0 || ! presetBank.getSnapshot(program, snapshot))
+        return;
+    
+    const std::pair<const char*, float> values[] = {
+        { rateSliderId, snapshot.rate }, { depthSliderId, snapshot.depth }, { centerDelaySliderId, snapshot.centreDelay },
+        { feedbackSliderId, snapshot.feedback }, { mixSliderId, snapshot.mix }
+    };
+    
+    for (auto& value : values)
+    {
+        auto* parameter = treeState.getParameter(value.first);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value.second));
+    }
+    
+    // If another program was picked in the meantime, its own update follows.
+    auto expected = program;
+    programOverride.compare_exchange_strong(expected, -1);
+    updateHostDisplay();
 }
 
 //==============================================================================
+void ChorusAudioProcessor::setRenderProfile (const RenderProfile& newProfile)
+{
+    renderInterpolation = (int) newProfile.quality.interpolation;
+    renderNumVoices = newProfile.quality.numVoices;
+    renderModulationInterval = newProfile.quality.modulationInterval;
+    
+    const auto factor = juce::jlimit(1, 8, juce::nextPowerOfTwo(newProfile.oversamplingFactor));
+    
+    if (factor != engineLayout.oversamplingFactor)
+    {
+        engineLayout.oversamplingFactor = factor;
+        requestEngineBuild();
+    }
+}
+
+ChorusAudioProcessor::RenderProfile ChorusAudioProcessor::getRenderProfile() const
+{
+    RenderProfile profile;
+    profile.quality.interpolation = (ChorusInterpolation) renderInterpolation.load();
+    profile.quality.numVoices = renderNumVoices;
+    profile.quality.modulationInterval = renderModulationInterval;
+    profile.oversamplingFactor = engineLayout.oversamplingFactor;
+    return profile;
+}
+
+void ChorusAudioProcessor::setMaximumCentreDelay (double newMaxCentreDelayMs)
+{
+    newMaxCentreDelayMs = juce::jlimit(1.0, ChorusEngine<float>::maxCentreDelayMs, newMaxCentreDelayMs);
+    
+    if (newMaxCentreDelayMs != engineLayout.maxCentreDelayMs)
+    {
+        engineLayout.maxCentreDelayMs = newMaxCentreDelayMs;
+        requestEngineBuild();
+    }
+}
+
+/** Queues a state for the new layout. The latency it will have is reported
+    here, on the message thread, rather than by the audio thread when it swaps
+    the state in; the host sees the new value a few blocks early, which it
+    treats like any other latency change.
+*/
+void ChorusAudioProcessor::requestEngineBuild()
+{
+    if (engineLayout.sampleRate <= 0)
+        return;
+    
+    engineRebuilder.requestBuild(engineLayout);
+    setLatencySamples(oversampling ? EngineState::getOfflineLatencyFor(engineLayout) : 0);
+}
+
+bool ChorusAudioProcessor::isOversampling (const EngineState& state) const noexcept
+{
+    return oversampling && state.oversampler != nullptr;
+}
+
+void ChorusAudioProcessor::applyProcessingMode (EngineState& state)
+{
+    const auto factor = isOversampling(state) ? (double) state.oversampler->getOversamplingFactor() : 1.0;
+    
+    state.engine.setSampleRate(getSampleRate() * factor);
+    
+    if (state.oversampler != nullptr)
+        state.oversampler->reset();
+}
+
+void ChorusAudioProcessor::resetEngineState (EngineState& state)
+{
+    state.engine.reset();
+    
+    if (state.oversampler != nullptr)
+        state.oversampler->reset();
+}
+
 void ChorusAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = getTotalNumOutputChannels();
+    // One delay line per input: a mono input feeding a stereo output shares a
+    // single line between both outputs.
+    const auto numChannels = juce::jmax(1, getTotalNumInputChannels());
+    
+    engineLayout.sampleRate = sampleRate;
+    engineLayout.maxBlockSize = samplesPerBlock;
+    engineLayout.numChannels = numChannels;
+    engineLayout.numOutputChannels = juce::jmax(1, getTotalNumOutputChannels());
+    
+    // The audio thread is stopped here, so the state can be swapped directly.
+    engineRebuilder.cancelPending();
+    incomingState.reset();
+    activeState = std::make_unique<EngineState>(engineLayout);
+    engineCrossfadeLength = juce::jmax(1, juce::roundToInt(sampleRate * engineCrossfadeSeconds));
     
-    chorusProcessor.prepare(spec);
+    qualityGovernor.reset();
+    loadMonitor.prepare(sampleRate);
+    sharedLfoValues.assign((size_t) juce::jmin(samplesPerBlock, SharedLfoClock::maxBlockSize), 0.0f);
+    
+    engineChannels.assign((size_t) engineLayout.numOutputChannels, nullptr);
+   #if CHORUS_WITH_CLAP
+    clapChannels.assign((size_t) engineLayout.numOutputChannels, nullptr);
+   #endif
+    
+    dryBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
+    bypassFadeLength = juce::jmax(1, juce::roundToInt(sampleRate * bypassFadeSeconds));
+    bypassFadePosition = bypassFadeLength;
+    engineNeedsReset = false;
+    
+    updateChannelPool();
+    
+    // Oversampling only runs offline. Whether it runs is settled here, where
+    // the latency its filters add can be reported to the host, and not when
+    // the audio thread sees the mode change.
+    renderingOffline = isNonRealtime();
+    oversampling = renderingOffline;
+    applyProcessingMode(*activeState);
+    setLatencySamples(isOversampling(*activeState) ? activeState->getOfflineLatency() : 0);
+}
+
+void ChorusAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    juce::AudioProcessor::setNonRealtime(isNonRealtime);
+    updateChannelPool();
+}
+
+void ChorusAudioProcessor::setParallelProcessing (ParallelProcessing newMode)
+{
+    parallelProcessing = newMode;
+    updateChannelPool();
+}
+
+void ChorusAudioProcessor::updateChannelPool()
+{
+    const auto mode = parallelProcessing.load();
+    const auto wanted = mode == ParallelProcessing::always || (mode == ParallelProcessing::offlineOnly && isNonRealtime());
+    
+    // One worker fewer than there are cores, as the audio thread does a share of the work too.
+    const auto numWorkers = wanted ? juce::jmin(engineLayout.numChannels, juce::SystemStats::getNumCpus()) - 1 : 0;
+    
+    if (numWorkers == (channelPool != nullptr ? channelPool->getNumWorkers() : 0))
+        return;
+    
+    auto newPool = numWorkers > 0 ? std::make_unique<ChannelThreadPool>(numWorkers) : nullptr;
+    
+    // The host may not have stopped the audio thread, so the pool is only
+    // swapped under the callback lock, and the old one is stopped outside it.
+    {
+        const juce::ScopedLock lock(getCallbackLock());
+        std::swap(channelPool, newPool);
+    }
 }
 
 void ChorusAudioProcessor::releaseResources()
@@ -137,17 +390,19 @@ bool ChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets its own delay line, so any discrete or surround
+    // layout up to maxNumChannels works.
+    const auto numOutputs = layouts.getMainOutputChannelSet().size();
+    
+    if (numOutputs < 1 || numOutputs > maxNumChannels)
         return false;
 
-    // This checks if the input layout matches the output layout
+    // The input layout has to match the output layout, except that a mono
+    // input may feed a stereo output.
    #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet()
+     && ! (layouts.getMainInputChannelSet() == juce::AudioChannelSet::mono()
+        && layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo()))
         return false;
    #endif
 
@@ -157,34 +412,531 @@ bool ChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 #endif
 
 void ChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    {
+        const LoadMonitor::ScopedMeasurement loadMeasurement(loadMonitor, buffer.getNumSamples());
+        const ScopedTrace callbackTrace(tracer.getSink(), TraceStage::callback);
+        processBlockUnmeasured(buffer);
+    }
+    
+    updateQualityTier(buffer.getNumSamples());
+}
+
+void ChorusAudioProcessor::processBlockUnmeasured (juce::AudioBuffer<float>& buffer)
+{
+    if (bypassFadePosition >= bypassFadeLength)
+    {
+        processChorusBlock(buffer);
+        return;
+    }
+    
+    // Coming back from bypass: the delay lines already hold the recent input, so
+    // the wet signal is valid straight away and only needs fading in.
+    if (engineNeedsReset)
+    {
+        resetEngineState(*activeState);
+        engineNeedsReset = false;
+    }
+    
+    const auto startGain = (float) bypassFadePosition / bypassFadeLength;
+    bypassFadePosition = juce::jmin(bypassFadeLength, bypassFadePosition + buffer.getNumSamples());
+    processWithBypassFade(buffer, startGain, (float) bypassFadePosition / bypassFadeLength);
+}
+
+void ChorusAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const LoadMonitor::ScopedMeasurement loadMeasurement(loadMonitor, buffer.getNumSamples());
+    const ScopedTrace callbackTrace(tracer.getSink(), TraceStage::callback);
+    
+    if (bypassFadePosition > 0)
+    {
+        const auto startGain = (float) bypassFadePosition / bypassFadeLength;
+        bypassFadePosition = juce::jmax(0, bypassFadePosition - buffer.getNumSamples());
+        processWithBypassFade(buffer, startGain, (float) bypassFadePosition / bypassFadeLength);
+        return;
+    }
+    
+    juce::ScopedNoDenormals noDenormals;
+    const auto totalNumInputChannels  = getTotalNumInputChannels();
+    const auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const auto numSamples = buffer.getNumSamples();
+    
+    // Nothing is audible, so a rebuilt state can take over without a crossfade.
+    beginEngineSwap();
+    
+    if (incomingState != nullptr)
+        finishEngineSwap();
+    
+    // Keep the delay lines fed so un-bypassing is instant. The oversampled
+    // engine runs at a different rate from the host buffer, so it is simply
+    // cleared on the way back in instead.
+    if (isOversampling(*activeState))
+        engineNeedsReset = true;
+    else
+        activeState->engine.pushBypassed(buffer.getArrayOfReadPointers(), totalNumInputChannels, numSamples);
+    
+    if (totalNumInputChannels == 1 && totalNumOutputChannels == 2)
+        buffer.copyFrom(1, 0, buffer, 0, 0, numSamples);
+    else
+        for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+            buffer.clear (i, 0, numSamples);
+}
+
+void ChorusAudioProcessor::processWithBypassFade (juce::AudioBuffer<float>& buffer, float startGain, float endGain)
+{
+    const auto totalNumInputChannels  = getTotalNumInputChannels();
+    const auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const auto numSamples = buffer.getNumSamples();
+    
+    if (numSamples > dryBuffer.getNumSamples() || totalNumInputChannels == 0)
+    {
+        processChorusBlock(buffer);
+        return;
+    }
+    
+    // The dry signal for each output: its own input, or the mono input when one
+    // input feeds two outputs.
+    for (auto channel = 0; channel < totalNumOutputChannels; ++channel)
+        dryBuffer.copyFrom(channel, 0, buffer, juce::jmin(channel, totalNumInputChannels - 1), 0, numSamples);
+    
+    processChorusBlock(buffer);
+    
+    for (auto channel = 0; channel < totalNumOutputChannels; ++channel)
+    {
+        buffer.applyGainRamp(channel, 0, numSamples, startGain, endGain);
+        buffer.addFromWithRamp(channel, 0, dryBuffer.getReadPointer(channel), numSamples, 1.0f - startGain, 1.0f - endGain);
+    }
+}
+
+void ChorusAudioProcessor::beginEngineSwap()
+{
+    if (incomingState != nullptr)
+        return;
+    
+    incomingState.reset(engineRebuilder.takeBuiltState());
+    
+    if (incomingState == nullptr)
+        return;
+    
+    // Start the new state off with the old one's delay history and LFO, so the
+    // crossfade is between two versions of the same sound rather than from a
+    // warm delay line to an empty one.
+    applyProcessingMode(*incomingState);
+    incomingState->engine.warmFrom(activeState->engine);
+    incomingState->countedRecoveries = incomingState->engine.getNumRecoveries();
+    engineCrossfadePosition = 0;
+}
+
+void ChorusAudioProcessor::finishEngineSwap()
+{
+    engineRebuilder.retire(activeState.release());
+    activeState = std::move(incomingState);
+}
+
+/** Adds the recoveries the state's engine made since the last call to the
+    total. Each engine keeps its own count, which a new state starts again
+    from, so the total is built up a block at a time rather than copied.
+*/
+void ChorusAudioProcessor::countRecoveries (EngineState& state) noexcept
+{
+    const auto total = state.engine.getNumRecoveries();
+    numFeedbackRecoveries.fetch_add(total - state.countedRecoveries, std::memory_order_relaxed);
+    state.countedRecoveries = total;
+}
+
+void ChorusAudioProcessor::processChorusBlock (juce::AudioBuffer<float>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const auto numSamples = buffer.getNumSamples();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+        buffer.clear (i, 0, numSamples);
 
     juce::dsp::AudioBlock<float> audioBlock {buffer};
     
-    auto* rawRate = treeState.getRawParameterValue(rateSliderId);
-    auto* rawDepth = treeState.getRawParameterValue(depthSliderId);
-    float depthScaled = scaleRange(*rawDepth, 0, 100, 0.0f, 1.0f);
-    auto* rawCenterDelay = treeState.getRawParameterValue(centerDelaySliderId);
-    auto* rawFeedback = treeState.getRawParameterValue(feedbackSliderId);
-    float feedbackScaled = scaleRange(*rawFeedback, 0, 95, 0.0f, 0.95f);
-    auto* rawMix = treeState.getRawParameterValue(mixSliderId);
-    float mixScaled = scaleRange(*rawMix, 0, 100, 0.0f, 1.0f);
+    const auto parameters = getBlockParameters();
+    
+    // A host that switches modes without preparing again gets the matching
+    // quality straight away, but the oversampling, and so the latency, only
+    // changes at the next prepareToPlay.
+    renderingOffline = isNonRealtime();
+    
+    beginEngineSwap();
+    
+    // The crossfade needs a second copy of the block. A host that sends more
+    // than it said it would gets the new state straight away instead.
+    if (incomingState != nullptr && numSamples > incomingState->crossfadeBuffer.getNumSamples())
+        finishEngineSwap();
+    
+    if (incomingState != nullptr)
+        for (auto channel = 0; channel < totalNumOutputChannels; ++channel)
+            incomingState->crossfadeBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+    
+    const auto quality = renderingOffline ? ChorusQuality { (ChorusInterpolation) renderInterpolation.load(), renderNumVoices, renderModulationInterval }
+                                          : QualityGovernor::getQualityForTier(deterministicRendering ? 0 : qualityGovernor.getTier());
+    
+    // Before the transport sync, so a reset on a jump snaps the ramps to this
+    // block's values rather than to whatever the last block left behind.
+    for (auto* state : { activeState.get(), incomingState.get() })
+        if (state != nullptr)
+            applyEngineSettings(*state, parameters, quality);
     
-    chorusProcessor.setRate(*rawRate);
-    chorusProcessor.setDepth(depthScaled);
-    chorusProcessor.setCentreDelay(*rawCenterDelay);
-    chorusProcessor.setFeedback(feedbackScaled);
-    chorusProcessor.setMix(mixScaled);
+    if (deterministicRendering)
+        syncToTransport(parameters.rate, numSamples);
+    else
+        applySharedModulation(parameters.rate, numSamples);
+    
+    renderEngineState(*activeState, audioBlock);
+    countRecoveries(*activeState);
+    
+    if (incomingState != nullptr)
+    {
+        juce::dsp::AudioBlock<float> incomingBlock (incomingState->crossfadeBuffer.getArrayOfWritePointers(), (size_t) totalNumOutputChannels, (size_t) numSamples);
+        renderEngineState(*incomingState, incomingBlock);
+        countRecoveries(*incomingState);
+        
+        const auto startGain = (float) engineCrossfadePosition / engineCrossfadeLength;
+        engineCrossfadePosition = juce::jmin(engineCrossfadeLength, engineCrossfadePosition + numSamples);
+        const auto endGain = (float) engineCrossfadePosition / engineCrossfadeLength;
+        
+        for (auto channel = 0; channel < totalNumOutputChannels; ++channel)
+        {
+            buffer.applyGainRamp(channel, 0, numSamples, 1.0f - startGain, 1.0f - endGain);
+            buffer.addFromWithRamp(channel, 0, incomingState->crossfadeBuffer.getReadPointer(channel), numSamples, startGain, endGain);
+        }
+        
+        if (engineCrossfadePosition >= engineCrossfadeLength)
+            finishEngineSwap();
+    }
+}
+
+void ChorusAudioProcessor::updateQualityTier (int numSamples) noexcept
+{
+    // Offline there is no deadline to keep, so the governor is left alone.
+    if (renderingOffline)
+        return;
+    
+    qualityGovernor.update(loadMonitor.getLastLoad(), numSamples / getSampleRate());
+}
+
+void ChorusAudioProcessor::applyEngineSettings (EngineState& state, const ParameterSnapshot& parameters, const ChorusQuality& quality)
+{
+    auto& engine = state.engine;
+    
+    ChorusParameters<float> engineParameters;
+    engineParameters.rate = parameters.rate;
+    engineParameters.depth = scaleRange(parameters.depth, 0, 100, 0.0f, 1.0f);
+    engineParameters.centreDelay = parameters.centreDelay;
+    engineParameters.feedback = scaleRange(parameters.feedback, 0, 95, 0.0f, 0.95f);
+    engineParameters.mix = scaleRange(parameters.mix, 0, 100, 0.0f, 1.0f);
+    
+    engine.setParameters(engineParameters);
+    engine.setLfoShape(lfoShape);
+    engine.setQuality(quality);
+    engine.setTraceSink(tracer.getSink());
+}
+
+void ChorusAudioProcessor::renderEngineState (EngineState& state, juce::dsp::AudioBlock<float>& block)
+{
+    auto& engine = state.engine;
     
-    chorusProcessor.process(juce::dsp::ProcessContextReplacing<float> (audioBlock));
+    if (isOversampling(state))
+    {
+        auto oversampledBlock = state.oversampler->processSamplesUp(block);
+        processChorus(engine, oversampledBlock);
+        state.oversampler->processSamplesDown(block);
+    }
+    else
+    {
+        processChorus(engine, block);
+    }
 }
 
+void ChorusAudioProcessor::setSharedModulationClock (bool shouldUseSharedClock)
+{
+    usingSharedClock = shouldUseSharedClock;
+    
+    if (shouldUseSharedClock)
+        updateSharedClock();
+    else
+        sharedClock = nullptr;
+}
+
+void ChorusAudioProcessor::timerCallback()
+{
+    applyProgramOverride();
+    engineRebuilder.freeRetiredState();
+    presetBank.freeRetiredTables();
+    
+    if (usingSharedClock)
+        updateSharedClock();
+}
+
+void ChorusAudioProcessor::updateSharedClock()
+{
+    // Looking a clock up can lock and allocate, so it happens here rather than
+    // on the audio thread, which keeps using its own LFO until the new clock
+    // has been published.
+    if (getSampleRate() <= 0)
+        return;
+    
+    // The rate the blocks actually render at, after programs and morphing. A
+    // clock only exists for whole-Hz rates; anything else keeps the engine's
+    // own LFO.
+    const auto rate = (double) blockRate.load();
+    const auto rateHz = (int) rate;
+    
+    if (rateHz < 1 || (double) rateHz != rate)
+    {
+        sharedClock = nullptr;
+        return;
+    }
+    
+    auto* clock = sharedClock.load();
+    
+    if (clock == nullptr || ! clock->matches(rate, lfoShape, getSampleRate()))
+        sharedClock = SharedLfoClock::getInstance(rateHz, lfoShape, getSampleRate());
+}
+
+void ChorusAudioProcessor::applySharedModulation (float rateHz, int numSamples)
+{
+    blockRate = rateHz;
+    auto* clock = sharedClock.load();
+    
+    if (clock != subscribedClock)
+    {
+        subscribedClock = clock;
+        
+        if (clock != nullptr)
+            clock->subscribe(clockSubscription);
+    }
+    
+    if (clock == nullptr || numSamples > (int) sharedLfoValues.size() || ! clock->matches(rateHz, lfoShape, getSampleRate()))
+        return;
+    
+    const auto endPhase = clock->read(clockSubscription, sharedLfoValues.data(), numSamples);
+    
+    // The shared clock runs at the host rate, so it can't drive an oversampled engine.
+    for (auto* state : { activeState.get(), incomingState.get() })
+    {
+        if (state != nullptr && ! isOversampling(*state))
+        {
+            state->engine.setPhase(endPhase);
+            state->engine.setExternalModulation(sharedLfoValues.data());
+        }
+    }
+}
+
+void ChorusAudioProcessor::setDeterministicRendering (bool shouldBeDeterministic)
+{
+    deterministicRendering = shouldBeDeterministic;
+    treeState.state.setProperty("deterministic", shouldBeDeterministic, nullptr);
+}
+
+void ChorusAudioProcessor::syncToTransport (float rateHz, int numSamples)
+{
+    auto* playHead = getPlayHead();
+    
+    if (playHead == nullptr)
+        return;
+    
+    bool isPlaying = false;
+    juce::int64 position = 0;
+    
+   #if JUCE_MAJOR_VERSION >= 7
+    const auto info = playHead->getPosition();
+    
+    if (! info.hasValue())
+        return;
+    
+    isPlaying = info->getIsPlaying();
+    
+    if (auto samples = info->getTimeInSamples())
+        position = *samples;
+    else if (auto ppq = info->getPpqPosition(); ppq.hasValue() && info->getBpm().hasValue())
+        position = (juce::int64) std::llround(*ppq * 60.0 / *info->getBpm() * getSampleRate());
+    else
+        return;
+   #else
+    juce::AudioPlayHead::CurrentPositionInfo info;
+    
+    if (! playHead->getCurrentPosition(info))
+        return;
+    
+    isPlaying = info.isPlaying;
+    position = info.timeInSamples;
+   #endif
+    
+    position += subBlockOffset;
+    
+    if (! isPlaying)
+    {
+        expectedTransportPosition = -1;
+        return;
+    }
+    
+    // On a jump (including the start of playback) forget everything that came
+    // before and start the LFO where the timeline says it should be. Between
+    // jumps the engine runs on from there, so rate changes don't step the phase.
+    if (position != expectedTransportPosition)
+    {
+        const auto cycles = (double) rateHz * (double) position / getSampleRate();
+        
+        const auto phase = juce::MathConstants<double>::twoPi * (cycles - std::floor(cycles));
+        
+        for (auto* state : { activeState.get(), incomingState.get() })
+        {
+            if (state != nullptr)
+            {
+                resetEngineState(*state);
+                state->engine.setPhase(phase);
+            }
+        }
+    }
+    
+    expectedTransportPosition = position + numSamples;
+}
+
+void ChorusAudioProcessor::processChorus (ChorusEngine<float>& engine, juce::dsp::AudioBlock<float>& block)
+{
+    if (getTotalNumInputChannels() == 1 && block.getNumChannels() == 2)
+    {
+        auto* left = block.getChannelPointer(0);
+        engine.processMonoToStereo(left, left, block.getChannelPointer(1), (int) block.getNumSamples());
+        return;
+    }
+    
+    auto* channels = engineChannels.data();
+    const auto numChannels = juce::jmin((int) block.getNumChannels(), (int) engineChannels.size());
+    const auto numSamples = (int) block.getNumSamples();
+    
+    for (auto channel = 0; channel < numChannels; ++channel)
+        channels[channel] = block.getChannelPointer((size_t) channel);
+    
+    const auto mode = parallelProcessing.load();
+    const auto useWorkers = channelPool != nullptr
+                         && (mode == ParallelProcessing::always || (mode == ParallelProcessing::offlineOnly && renderingOffline));
+    
+    if (useWorkers)
+        engine.process(channels, numChannels, numSamples, *channelPool);
+    else
+        engine.process(channels, numChannels, numSamples);
+}
+
+#if CHORUS_WITH_CLAP
+//==============================================================================
+clap_process_status ChorusAudioProcessor::clap_direct_process (const clap_process* process) noexcept
+{
+    const auto numFrames = (int) process->frames_count;
+    
+    if (process->audio_outputs_count < 1 || numFrames == 0)
+        return CLAP_PROCESS_CONTINUE;
+    
+    const auto* events = process->in_events;
+    const auto numEvents = events != nullptr ? events->size(events) : 0u;
+    auto nextEvent = 0u;
+    auto inputIsSilent = true;
+    
+    {
+        // The whole callback is measured once here, so the ranges are
+        // processed without processBlock's own measurement.
+        const LoadMonitor::ScopedMeasurement loadMeasurement(loadMonitor, numFrames);
+        const ScopedTrace callbackTrace(tracer.getSink(), TraceStage::callback);
+        
+        // Events arrive sorted by time. Each run of samples up to the next event is
+        // processed as a block of its own, with the parameters as they stand then.
+        for (auto start = 0; start < numFrames;)
+        {
+            auto end = numFrames;
+            
+            for (; nextEvent < numEvents; ++nextEvent)
+            {
+                const auto* event = events->get(events, nextEvent);
+                
+                if ((int) event->time > start)
+                {
+                    end = juce::jmin(numFrames, (int) event->time);
+                    break;
+                }
+                
+                applyClapEvent(*event);
+            }
+            
+            subBlockOffset = start;
+            
+            if (! processClapRange(*process, start, end - start))
+                inputIsSilent = false;
+            
+            start = end;
+        }
+    }
+    
+    subBlockOffset = 0;
+    updateQualityTier(numFrames);
+    process->audio_outputs[0].constant_mask = 0;
+    
+    clapSilentSamples = inputIsSilent ? clapSilentSamples + numFrames : 0;
+    
+    if (clapSilentSamples > (juce::int64) std::ceil(getTailLengthSeconds() * getSampleRate()))
+        return CLAP_PROCESS_SLEEP;
+    
+    return CLAP_PROCESS_CONTINUE;
+}
+
+void ChorusAudioProcessor::applyClapEvent (const clap_event_header_t& event)
+{
+    if (event.space_id != CLAP_CORE_EVENT_SPACE_ID || event.type != CLAP_EVENT_PARAM_VALUE)
+        return;
+    
+    const auto& valueEvent = reinterpret_cast<const clap_event_param_value_t&>(event);
+    
+    for (auto& clapParameter : clapParameters)
+    {
+        if (clapParameter.id == valueEvent.param_id)
+        {
+            // The wrapper publishes every parameter with a 0 to 1 range.
+            const auto value = (float) valueEvent.value;
+            clapParameter.parameter->setValue(value);
+            clapParameter.parameter->sendValueChangedMessageToListeners(value);
+            return;
+        }
+    }
+}
+
+bool ChorusAudioProcessor::processClapRange (const clap_process& process, int startSample, int numSamples)
+{
+    const auto& output = process.audio_outputs[0];
+    const auto* input = process.audio_inputs_count > 0 ? &process.audio_inputs[0] : nullptr;
+    
+    auto* channels = clapChannels.data();
+    const auto numChannels = juce::jmin((int) output.channel_count, (int) clapChannels.size());
+    const auto numInputs = input != nullptr ? juce::jmin((int) input->channel_count, numChannels) : 0;
+    auto isSilent = true;
+    
+    for (auto channel = 0; channel < numChannels; ++channel)
+    {
+        channels[channel] = output.data32[channel] + startSample;
+        
+        if (channel >= numInputs)
+            continue;
+        
+        const auto* source = input->data32[channel] + startSample;
+        
+        if (source != channels[channel])
+            juce::FloatVectorOperations::copy(channels[channel], source, numSamples);
+        
+        const auto range = juce::FloatVectorOperations::findMinAndMax(source, numSamples);
+        isSilent = isSilent && range.getStart() == 0.0f && range.getEnd() == 0.0f;
+    }
+    
+    juce::AudioBuffer<float> buffer (channels, numChannels, numSamples);
+    processBlockUnmeasured(buffer);
+    return isSilent;
+}
+#endif
+
 float ChorusAudioProcessor::scaleRange(const float &input, const float &inputLow, const float &inputHigh, const float &outputLow, const float &outputHigh){
     return ((input - inputLow) / (inputHigh - inputLow)) * (outputHigh - outputLow) + outputLow;
 }
@@ -201,18 +953,70 @@ juce::AudioProcessorEditor* ChorusAudioProcessor::createEditor()
 }
 
 //==============================================================================
+namespace
+{
+    /** The parameter ids in the order ChorusState stores their values. */
+    const char* const stateParameterIds[ChorusState::numParameters] = {
+        rateSliderId, depthSliderId, centerDelaySliderId, feedbackSliderId, mixSliderId, morphSliderId
+    };
+}
+
 void ChorusAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    juce::MemoryOutputStream stream(destData, false);
-            treeState.state.writeToStream (stream);
+    // Built from the atomics the audio thread reads, so saving never touches
+    // the ValueTree.
+    ChorusState state;
+    
+    for (auto i = 0; i < ChorusState::numParameters; ++i)
+        state.values[i] = *treeState.getRawParameterValue(stateParameterIds[i]);
+    
+    state.deterministic = deterministicRendering;
+    state.morphTarget = morphTarget;
+    state.program = currentProgram;
+    state.writeTo(destData);
 }
 
 void ChorusAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    juce::ValueTree tree = juce::ValueTree::readFromData (data, size_t (sizeInBytes));
-            if (tree.isValid()) {
-                treeState.state = tree;
-            }
+    ChorusState state;
+    
+    for (auto i = 0; i < ChorusState::numParameters; ++i)
+    {
+        auto* parameter = treeState.getParameter(stateParameterIds[i]);
+        state.values[i] = parameter->convertFrom0to1(parameter->getDefaultValue());
+    }
+    
+    if (state.readFrom(data, (size_t) sizeInBytes))
+    {
+        juce::ValueTree tree (treeState.state.getType());
+        
+        for (auto i = 0; i < ChorusState::numParameters; ++i)
+            tree.appendChild(juce::ValueTree ("PARAM", {}, { { "id", stateParameterIds[i] }, { "value", state.values[i] } }), nullptr);
+        
+        tree.setProperty("deterministic", state.deterministic, nullptr);
+        tree.setProperty("morphTarget", state.morphTarget, nullptr);
+        
+        // replaceState hands the new values to the parameters through their
+        // atomics, so it is safe while the audio thread is running.
+        treeState.replaceState(tree);
+        deterministicRendering = state.deterministic;
+        morphTarget = state.morphTarget;
+        
+        if (juce::isPositiveAndBelow(state.program, presetBank.getNumPrograms()))
+            currentProgram = state.program;
+        
+        return;
+    }
+    
+    // Sessions saved before the binary format hold the whole ValueTree.
+    auto tree = juce::ValueTree::readFromData(data, (size_t) sizeInBytes);
+    
+    if (tree.isValid() && tree.hasType(treeState.state.getType()))
+    {
+        treeState.replaceState(tree);
+        deterministicRendering = (bool) tree.getProperty("deterministic", false);
+        morphTarget = (int) tree.getProperty("morphTarget", 1);
+    }
 }
 
 //==============================================================================
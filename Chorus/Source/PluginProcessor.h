@@ -9,6 +9,19 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ChorusEngine.h"
+#include "QualityGovernor.h"
+#include "LoadMonitor.h"
+#include "AudioTracer.h"
+#include "ChannelThreadPool.h"
+#include "SharedLfoClock.h"
+#include "EngineRebuilder.h"
+#include "PresetBank.h"
+#include "ChorusState.h"
+
+#if CHORUS_WITH_CLAP
+ #include <clap-juce-extensions/clap-juce-extensions.h>
+#endif
 
 #define rateSliderId "rate"
 #define rateSliderName "Rate"
@@ -25,11 +38,18 @@
 #define mixSliderId "mix"
 #define mixSliderName "Mix"
 
+#define morphSliderId "morph"
+#define morphSliderName "Morph"
+
 
 //==============================================================================
 /**
 */
-class ChorusAudioProcessor  : public juce::AudioProcessor
+class ChorusAudioProcessor  : public juce::AudioProcessor,
+                             #if CHORUS_WITH_CLAP
+                              public clap_juce_extensions::clap_juce_audio_processor_capabilities,
+                             #endif
+                              private juce::Timer
 {
 public:
     //==============================================================================
@@ -44,7 +64,23 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
+    /** The widest bus accepted, enough for 9.1.6 or 16 discrete channels. */
+    static constexpr int maxNumChannels = 16;
+
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
+    
+   #if CHORUS_WITH_CLAP
+    /** In a CLAP host the plugin reads the event list itself and splits the
+        block at each parameter change, so automation lands on the sample it
+        was timestamped with instead of at the start of the block. Once the
+        input has been silent for longer than the tail, the host is told the
+        plugin can sleep.
+    */
+    bool supportsDirectProcess() override { return true; }
+    clap_process_status clap_direct_process (const clap_process* process) noexcept override;
+   #endif
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -72,10 +108,234 @@ public:
     
     juce::AudioProcessorValueTreeState treeState;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    
+    //==============================================================================
+    /** The share of each block's duration this instance may spend in processBlock
+        before it starts stepping its quality down.
+    */
+    void setCpuBudget (double fractionOfBlock) noexcept { qualityGovernor.setBudget(fractionOfBlock); }
+    double getCpuBudget() const noexcept { return qualityGovernor.getBudget(); }
+    
+    void setAdaptiveQualityEnabled (bool shouldBeEnabled) noexcept { qualityGovernor.setEnabled(shouldBeEnabled); }
+    
+    /** 0 is full quality, higher tiers are progressively cheaper. Safe to call from any thread. */
+    int getQualityTier() const noexcept { return qualityGovernor.getTier(); }
+    
+    /** The smoothed callback time as a fraction of the block duration. */
+    double getCpuLoad() const noexcept { return qualityGovernor.getSmoothedLoad(); }
+    
+    /** Every callback's duration as a fraction of the audio it produced, binned
+        since the last prepareToPlay or resetLoadHistogram. On by default. Safe
+        to call from any thread.
+    */
+    LoadMonitor::Snapshot getLoadHistogram() const noexcept { return loadMonitor.getSnapshot(); }
+    void resetLoadHistogram() noexcept { loadMonitor.reset(); }
+    void setLoadMonitoringEnabled (bool shouldBeEnabled) noexcept { loadMonitor.setEnabled(shouldBeEnabled); }
+    bool isLoadMonitoringEnabled() const noexcept { return loadMonitor.isEnabled(); }
+    
+    /** Records when the host callback and each engine stage ran, on every
+        thread involved, and writes it to file as Chrome trace-event JSON until
+        stopTracing() is called. Costs nothing while off. Call from the message
+        thread.
+    */
+    bool startTracing (const juce::File& file) { return tracer.start(file); }
+    void stopTracing() { tracer.stop(); }
+    bool isTracing() const noexcept { return tracer.isTracing(); }
+    
+    /** How many times a runaway or non-finite feedback loop has been caught and
+        cleared since the plugin was created. Safe to call from any thread.
+    */
+    uint32_t getNumFeedbackRecoveries() const noexcept { return numFeedbackRecoveries.load(std::memory_order_relaxed); }
+    
+    //==============================================================================
+    /** The quality used instead of the adaptive tiers whenever the host renders
+        offline (isNonRealtime() is true). By default a bounce uses Lagrange
+        interpolation, full-rate modulation and 2x oversampling, which costs
+        more than real time can afford but keeps the single voice heard while
+        playing, so the character of the chorus doesn't change on export.
+    */
+    struct RenderProfile
+    {
+        ChorusQuality quality { ChorusInterpolation::lagrange3rd, 1, 1 };
+        
+        /** 1, 2, 4 or 8. A change is built in the background and crossfaded
+            in, so it doesn't need the transport to stop.
+        */
+        int oversamplingFactor = 2;
+    };
+    
+    /** Call from the message thread. */
+    void setRenderProfile (const RenderProfile& newProfile);
+    RenderProfile getRenderProfile() const;
+    
+    /** The longest centre delay the delay lines are sized for, 1 to 100 ms.
+        Lowering it saves memory when many instances are loaded. Like the
+        oversampling factor, a change is built in the background and
+        crossfaded in. Call from the message thread.
+    */
+    void setMaximumCentreDelay (double newMaxCentreDelayMs);
+    double getMaximumCentreDelay() const noexcept { return engineLayout.maxCentreDelayMs; }
+    
+    /** True while the render profile is in use. */
+    bool isRenderingOffline() const noexcept { return renderingOffline; }
+    
+    //==============================================================================
+    enum class ParallelProcessing
+    {
+        offlineOnly,    // spread channels across worker threads only when isNonRealtime() is true
+        always,
+        never
+    };
+    
+    /** The worker threads only exist while the mode calls for them: always,
+        or offlineOnly while the host renders offline. Idle workers sleep until
+        there is work.
+    */
+    void setParallelProcessing (ParallelProcessing newMode);
+    ParallelProcessing getParallelProcessing() const noexcept { return parallelProcessing; }
+    
+    //==============================================================================
+    /** Opt in to the process-wide LFO shared by every instance with the same rate,
+        shape and sample rate, so stacked instances stay phase-locked and the
+        oscillator is evaluated once per callback. Clocks run at whole-Hz rates
+        only, so a block whose program or morph lands between them uses the
+        instance's own LFO. Call from the message thread.
+    */
+    void setSharedModulationClock (bool shouldUseSharedClock);
+    bool isUsingSharedModulationClock() const noexcept { return usingSharedClock; }
+    
+    void setLfoShape (LfoShape newShape) noexcept { lfoShape = newShape; }
+    
+    //==============================================================================
+    /** In deterministic mode the LFO phase follows the host timeline and all delay
+        state is cleared whenever the transport jumps, so rendering the same
+        region twice gives bit-identical output. The adaptive quality tiers and
+        the shared clock are bypassed while it is on, as both depend on things
+        outside the session. The setting is saved with the plugin state.
+    */
+    void setDeterministicRendering (bool shouldBeDeterministic);
+    bool isDeterministicRendering() const noexcept { return deterministicRendering; }
+    
+    //==============================================================================
+    /** Appends the programs in a user bank file to the factory ones, replacing
+        any loaded before. See PresetBank.h for the format. Call from the
+        message thread.
+    */
+    bool loadUserPresetBank (const juce::File& bankFile);
+    
+    /** The ranges of the parameters a program sets, in the bank's order. */
+    PresetBank::Ranges getProgramRanges() const;
+    
+    /** The program the morph parameter blends towards: at 0 the knobs are used
+        as they are, at 100 the target program is. Saved with the plugin state.
+    */
+    void setMorphTarget (int programIndex);
+    int getMorphTarget() const noexcept { return morphTarget; }
 
 private:
     
-    juce::dsp::Chorus<float> chorusProcessor;
+    void timerCallback() override;
+    void applyProgramOverride();
+    void updateSharedClock();
+    ParameterSnapshot getBlockParameters();
+    void syncToTransport (float rateHz, int numSamples);
+    void applySharedModulation (float rateHz, int numSamples);
+    
+    void requestEngineBuild();
+    bool isOversampling (const EngineState& state) const noexcept;
+    void applyProcessingMode (EngineState& state);
+    void resetEngineState (EngineState& state);
+    void beginEngineSwap();
+    void finishEngineSwap();
+    void countRecoveries (EngineState& state) noexcept;
+    void updateChannelPool();
+    void processBlockUnmeasured (juce::AudioBuffer<float>& buffer);
+    void updateQualityTier (int numSamples) noexcept;
+    void processChorusBlock (juce::AudioBuffer<float>& buffer);
+    void processWithBypassFade (juce::AudioBuffer<float>& buffer, float startGain, float endGain);
+    void applyEngineSettings (EngineState& state, const ParameterSnapshot& parameters, const ChorusQuality& quality);
+    void renderEngineState (EngineState& state, juce::dsp::AudioBlock<float>& block);
+    void processChorus (ChorusEngine<float>& engine, juce::dsp::AudioBlock<float>& block);
+    
+   #if CHORUS_WITH_CLAP
+    void applyClapEvent (const clap_event_header_t& event);
+    bool processClapRange (const clap_process& process, int startSample, int numSamples);
+    
+    /** The wrapper gives every parameter the hash of its JUCE id as its CLAP id. */
+    struct ClapParameter
+    {
+        clap_id id;
+        juce::AudioProcessorParameter* parameter;
+    };
+    
+    std::vector<ClapParameter> clapParameters;
+    std::vector<float*> clapChannels;
+    juce::int64 clapSilentSamples = 0;
+   #endif
+    
+    /** Where the block being processed starts within the host callback. Only
+        the CLAP path splits callbacks, so it is otherwise always 0.
+    */
+    int subBlockOffset = 0;
+    
+    /** The state the audio thread is running, and while a rebuilt one is being
+        crossfaded in, that one too. Both belong to the audio thread except
+        during prepareToPlay.
+    */
+    std::unique_ptr<EngineState> activeState, incomingState;
+    EngineRebuilder engineRebuilder;
+    EngineLayout engineLayout;
+    
+    static constexpr double engineCrossfadeSeconds = 0.01;
+    int engineCrossfadeLength = 1, engineCrossfadePosition = 0;
+    std::atomic<uint32_t> numFeedbackRecoveries { 0 };
+    
+    QualityGovernor qualityGovernor;
+    LoadMonitor loadMonitor;
+    AudioTracer tracer;
+    
+    PresetBank presetBank;
+    std::atomic<int> currentProgram { 0 }, pendingProgram { -1 }, morphTarget { 1 };
+    
+    /** While a program switch is waiting for the message thread's timer to copy
+        it into the parameters, the audio thread uses its snapshot instead of the
+        knobs.
+    */
+    std::atomic<int> programOverride { -1 };
+    ParameterSnapshot programSnapshot;
+    
+    std::atomic<int> renderInterpolation { (int) RenderProfile().quality.interpolation };
+    std::atomic<int> renderNumVoices { RenderProfile().quality.numVoices };
+    std::atomic<int> renderModulationInterval { RenderProfile().quality.modulationInterval };
+    std::atomic<bool> renderingOffline { false };
+    
+    /** Whether states with an oversampler use it. Only changed in prepareToPlay. */
+    bool oversampling = false;
+    
+    /** The block's channel pointers as the engine takes them, one per output. */
+    std::vector<float*> engineChannels;
+    
+    std::unique_ptr<ChannelThreadPool> channelPool;
+    std::atomic<ParallelProcessing> parallelProcessing { ParallelProcessing::offlineOnly };
+    
+    std::atomic<LfoShape> lfoShape { LfoShape::sine };
+    std::atomic<bool> usingSharedClock { false };
+    std::atomic<SharedLfoClock*> sharedClock { nullptr };
+    
+    /** The rate of the last block, for the timer to choose a clock by. */
+    std::atomic<float> blockRate { 0.0f };
+    SharedLfoClock* subscribedClock = nullptr;
+    SharedLfoClock::Subscription clockSubscription;
+    std::vector<float> sharedLfoValues;
+    
+    std::atomic<bool> deterministicRendering { false };
+    juce::int64 expectedTransportPosition = -1;
+    
+    /** Bypass crossfades between the processed and dry signals over this long. */
+    static constexpr double bypassFadeSeconds = 0.005;
+    juce::AudioBuffer<float> dryBuffer;
+    int bypassFadeLength = 1, bypassFadePosition = 1;
+    bool engineNeedsReset = false;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusAudioProcessor)
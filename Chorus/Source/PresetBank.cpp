@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include "FactoryPresets.h"
+
+//==============================================================================
+PresetBank::PresetBank()
+{
+    const auto parsed = parseBank (FactoryPresets::bankData, (size_t) FactoryPresets::bankDataSize, factoryPrograms);
+    jassert (parsed && ! factoryPrograms.empty());
+    juce::ignoreUnused (parsed);
+
+    publish ({});
+}
+
+bool PresetBank::loadUserBank (const juce::File& bankFile, const Ranges& ranges)
+{
+    juce::MemoryMappedFile mappedFile (bankFile, juce::MemoryMappedFile::readOnly);
+
+    if (mappedFile.getData() == nullptr)
+        return false;
+
+    std::vector<Program> userPrograms;
+
+    if (! parseBank (mappedFile.getData(), mappedFile.getSize(), userPrograms))
+        return false;
+
+    // The audio thread uses a program's snapshot as it is, before it reaches
+    // the parameters, so nothing out of range may get into the table.
+    for (auto& program : userPrograms)
+    {
+        auto& p = program.parameters;
+        float* values[] = { &p.rate, &p.depth, &p.centreDelay, &p.feedback, &p.mix };
+
+        for (size_t i = 0; i < ranges.size(); ++i)
+            *values[i] = ranges[i].snapToLegalValue (*values[i]);
+    }
+
+    publish (userPrograms);
+    return true;
+}
+
+void PresetBank::publish (const std::vector<Program>& userPrograms)
+{
+    auto table = std::make_unique<Table>();
+
+    for (auto* programs : { &factoryPrograms, &userPrograms })
+    {
+        for (auto& program : *programs)
+        {
+            table->snapshots.push_back (program.parameters);
+            table->names.add (program.name);
+        }
+    }
+
+    numPrograms = table->size();
+    current = table.get();
+    tables.push_back (std::move (table));
+    freeRetiredTables();
+}
+
+void PresetBank::freeRetiredTables()
+{
+    // Read after current was last stored, so if the audio thread has picked
+    // up an older table and validated it, this sees it.
+    const auto* reading = audioReading.load();
+    const auto* latest = current.load();
+
+    tables.erase (std::remove_if (tables.begin(), tables.end(),
+                                  [reading, latest] (const std::unique_ptr<Table>& table)
+                                  {
+                                      return table.get() != latest && table.get() != reading;
+                                  }),
+                  tables.end());
+}
+
+juce::String PresetBank::getProgramName (int index) const
+{
+    return current.load()->names[index];
+}
+
+bool PresetBank::getSnapshot (int index, ParameterSnapshot& destination) const noexcept
+{
+    const auto* table = current.load();
+
+    if (! juce::isPositiveAndBelow (index, table->size()))
+        return false;
+
+    destination = table->snapshots[(size_t) index];
+    return true;
+}
+
+bool PresetBank::getSnapshotOnAudioThread (int index, ParameterSnapshot& destination) const noexcept
+{
+    // Mark the table, then check it is still the current one. If a load
+    // replaced it in between, the message thread may not have seen the mark,
+    // so start again with the new table.
+    const Table* table;
+
+    do
+    {
+        table = current.load();
+        audioReading.store (table);
+    }
+    while (current.load() != table);
+
+    const auto found = juce::isPositiveAndBelow (index, table->size());
+
+    if (found)
+        destination = table->snapshots[(size_t) index];
+
+    audioReading.store (nullptr, std::memory_order_release);
+    return found;
+}
+
+//==============================================================================
+bool PresetBank::parseBank (const void* data, size_t size, std::vector<Program>& programs)
+{
+    const auto* bytes = static_cast<const char*> (data);
+
+    if (size < (size_t) headerSize || std::memcmp (bytes, "CHPB", 4) != 0)
+        return false;
+
+    const auto version = juce::ByteOrder::littleEndianInt (bytes + 4);
+    const auto numPrograms = juce::ByteOrder::littleEndianInt (bytes + 8);
+
+    if (version != 1 || numPrograms > (size - (size_t) headerSize) / (size_t) recordSize)
+        return false;
+
+    for (juce::uint32 i = 0; i < numPrograms; ++i)
+    {
+        const auto* record = bytes + headerSize + (size_t) i * (size_t) recordSize;
+        const auto* values = record + nameLength;
+
+        auto readFloat = [values] (int index)
+        {
+            const auto bits = juce::ByteOrder::littleEndianInt (values + index * 4);
+            float value;
+            std::memcpy (&value, &bits, sizeof (value));
+            return value;
+        };
+
+        Program program;
+        program.name = juce::String::fromUTF8 (record, (int) ::strnlen (record, (size_t) nameLength));
+        program.parameters = { readFloat (0), readFloat (1), readFloat (2), readFloat (3), readFloat (4) };
+
+        const auto& p = program.parameters;
+
+        for (auto value : { p.rate, p.depth, p.centreDelay, p.feedback, p.mix })
+            if (! std::isfinite (value))
+                return false;
+
+        programs.push_back (program);
+    }
+
+    return true;
+}
+
+void PresetBank::writeBank (juce::OutputStream& stream, const std::vector<Program>& programs)
+{
+    stream.write ("CHPB", 4);
+    stream.writeInt (1);
+    stream.writeInt ((int) programs.size());
+
+    for (auto& program : programs)
+    {
+        char name[nameLength] = {};
+        program.name.copyToUTF8 (name, (size_t) nameLength);
+        stream.write (name, (size_t) nameLength);
+
+        const auto& p = program.parameters;
+
+        for (auto value : { p.rate, p.depth, p.centreDelay, p.feedback, p.mix })
+            stream.writeFloat (value);
+    }
+}
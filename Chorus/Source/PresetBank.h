@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    The program bank: the factory programs compiled into the plugin, followed
+    by any user programs loaded from a bank file. Each program is stored as a
+    ready-to-use ParameterSnapshot, so switching programs on the audio thread
+    is a copy of five floats.
+
+    Bank files, factory and user alike, are little-endian:
+
+        char[4]   "CHPB"
+        uint32    version (1)
+        uint32    number of programs
+        then per program:
+            char[32]  name, UTF-8, zero padded
+            float[5]  rate, depth, centre delay, feedback, mix
+
+    The values are in the same units as the plugin's parameters. A bank
+    holding a NaN or infinite value is rejected, and a user bank's values are
+    clamped to their parameters' ranges as it is loaded.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** One value per plugin parameter, in the parameter's own units. */
+struct ParameterSnapshot
+{
+    float rate = 50.0f, depth = 0.0f, centreDelay = 50.0f, feedback = 0.0f, mix = 0.0f;
+
+    /** a at amount 0, b at amount 1. */
+    static ParameterSnapshot interpolate (const ParameterSnapshot& a, const ParameterSnapshot& b, float amount) noexcept
+    {
+        auto lerp = [amount] (float x, float y)    { return x + amount * (y - x); };
+        return { lerp (a.rate, b.rate), lerp (a.depth, b.depth), lerp (a.centreDelay, b.centreDelay),
+                 lerp (a.feedback, b.feedback), lerp (a.mix, b.mix) };
+    }
+};
+
+//==============================================================================
+class PresetBank
+{
+public:
+    struct Program
+    {
+        juce::String name;
+        ParameterSnapshot parameters;
+    };
+
+    /** The range of each value in a program, in the order they are stored. */
+    using Ranges = std::array<juce::NormalisableRange<float>, 5>;
+
+    /** Loads the factory programs. */
+    PresetBank();
+
+    /** Replaces the user programs with the ones in a bank file, which is
+        memory-mapped and read in place. Each value is snapped to its range,
+        as the parameter would snap it. Returns false, leaving the bank as it
+        was, if the file can't be mapped or isn't a valid bank. Call from the
+        message thread.
+    */
+    bool loadUserBank (const juce::File& bankFile, const Ranges& ranges);
+
+    /** Safe on any thread. */
+    int getNumPrograms() const noexcept    { return numPrograms.load(); }
+    int getNumFactoryPrograms() const noexcept    { return (int) factoryPrograms.size(); }
+
+    /** Call from the message thread. */
+    juce::String getProgramName (int index) const;
+
+    /** Copies a program's snapshot into destination. Call from the message
+        thread.
+    */
+    bool getSnapshot (int index, ParameterSnapshot& destination) const noexcept;
+
+    /** The same for the audio thread. Lock-free and doesn't allocate. While it
+        copies, it marks the table it is reading so the message thread won't
+        free it; only one thread besides the message thread may call it.
+    */
+    bool getSnapshotOnAudioThread (int index, ParameterSnapshot& destination) const noexcept;
+
+    /** Frees the tables replaced by earlier loads that the audio thread is no
+        longer reading. Call from the message thread, e.g. on a timer.
+    */
+    void freeRetiredTables();
+
+    //==============================================================================
+    /** Parses a bank in memory, appending its programs. Returns false if the
+        bank is malformed or holds a value that isn't finite.
+    */
+    static bool parseBank (const void* data, size_t size, std::vector<Program>& programs);
+    static void writeBank (juce::OutputStream& stream, const std::vector<Program>& programs);
+
+private:
+    static constexpr int nameLength = 32;
+    static constexpr int recordSize = nameLength + 5 * (int) sizeof (float);
+    static constexpr int headerSize = 12;
+
+    /** The programs as the audio thread sees them. A table is never changed
+        once published. A replaced one is kept until the audio thread isn't
+        reading it, then freed on the message thread.
+    */
+    struct Table
+    {
+        std::vector<ParameterSnapshot> snapshots;
+        juce::StringArray names;
+
+        int size() const noexcept    { return (int) snapshots.size(); }
+    };
+
+    void publish (const std::vector<Program>& userPrograms);
+
+    std::vector<Program> factoryPrograms;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::atomic<const Table*> current { nullptr };
+    std::atomic<int> numPrograms { 0 };
+
+    /** The table the audio thread is copying from, or null between copies. */
+    mutable std::atomic<const Table*> audioReading { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+
+    Watches the load LoadMonitor measures for each callback, its duration
+    relative to the length of the block, and steps the chorus quality down
+    when the instance goes over its CPU budget, and back up again once there
+    is headroom.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusEngine.h"
+
+//==============================================================================
+class QualityGovernor
+{
+public:
+    /** Tier 0 is the engine's default quality, which sounds the same as
+        juce::dsp::Chorus; each following tier evaluates the LFO less often.
+
+        Only the modulation rate is governed. Tier 0 already uses linear
+        interpolation and a single voice, the cheapest of each, so there is
+        nothing below it to step down to, and making tier 0 richer would
+        change how every existing session sounds.
+    */
+    static constexpr int numTiers = 3;
+
+    static ChorusQuality getQualityForTier (int tier) noexcept
+    {
+        switch (tier)
+        {
+            case 0:  return {};
+            case 1:  return { ChorusInterpolation::linear, 1, 8 };
+            default: return { ChorusInterpolation::linear, 1, 32 };
+        }
+    }
+
+    //==============================================================================
+    /** The fraction of the block duration this instance may spend processing. */
+    void setBudget (double newFractionOfBlock) noexcept   { budget = juce::jlimit (0.01, 1.0, newFractionOfBlock); }
+    double getBudget() const noexcept                      { return budget; }
+
+    void setEnabled (bool shouldBeEnabled) noexcept        { enabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept                        { return enabled; }
+
+    int getTier() const noexcept                           { return tier; }
+    double getSmoothedLoad() const noexcept                { return smoothedLoad; }
+
+    void reset() noexcept
+    {
+        tier = 0;
+        restartMeasurement();
+    }
+
+    //==============================================================================
+    /** Called from the audio thread once per callback with its load, the
+        time spent processing as a fraction of blockSeconds. Returns the tier
+        to use for the next block.
+    */
+    int update (double load, double blockSeconds) noexcept
+    {
+        if (! enabled)
+        {
+            tier = 0;
+            return 0;
+        }
+
+        if (blockSeconds <= 0.0)
+            return tier;
+
+        const auto smoothed = measuring ? smoothedLoad + smoothing * (load - smoothedLoad) : load;
+        smoothedLoad = smoothed;
+        measuring = true;
+
+        const auto currentBudget = budget.load();
+        auto currentTier = tier.load();
+
+        if (smoothed > currentBudget)
+        {
+            headroomSeconds = 0.0;
+
+            if (++blocksOverBudget >= blocksBeforeStepDown && currentTier < numTiers - 1)
+            {
+                tier = currentTier + 1;
+                restartMeasurement();
+            }
+        }
+        else
+        {
+            blocksOverBudget = 0;
+
+            if (smoothed < currentBudget * stepUpThreshold)
+            {
+                headroomSeconds += blockSeconds;
+
+                if (headroomSeconds >= secondsBeforeStepUp && currentTier > 0)
+                {
+                    tier = currentTier - 1;
+                    restartMeasurement();
+                }
+            }
+            else
+            {
+                headroomSeconds = 0.0;
+            }
+        }
+
+        return tier;
+    }
+
+private:
+    void restartMeasurement() noexcept
+    {
+        measuring = false;
+        blocksOverBudget = 0;
+        headroomSeconds = 0.0;
+    }
+
+    //==============================================================================
+    static constexpr double smoothing = 0.2;
+    static constexpr int blocksBeforeStepDown = 4;
+
+    /** Hysteresis: the load has to drop well below the budget, and stay there,
+        before the next tier up is tried.
+    */
+    static constexpr double stepUpThreshold = 0.5;
+    static constexpr double secondsBeforeStepUp = 2.0;
+
+    std::atomic<double> budget { 0.25 };
+    std::atomic<bool> enabled { true };
+    std::atomic<int> tier { 0 };
+    std::atomic<double> smoothedLoad { 0.0 };
+
+    bool measuring = false;
+    int blocksOverBudget = 0;
+    double headroomSeconds = 0.0;
+};
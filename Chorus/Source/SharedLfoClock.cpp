@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    SharedLfoClock.cpp
+
+  ==============================================================================
+*/
+
+#include "SharedLfoClock.h"
+
+//==============================================================================
+SharedLfoClock* SharedLfoClock::getInstance (int rateHz, LfoShape shape, double sampleRate)
+{
+    static juce::CriticalSection lock;
+    static std::vector<std::unique_ptr<SharedLfoClock>> clocks;
+
+    const juce::ScopedLock sl (lock);
+
+    for (auto& clock : clocks)
+        if (clock->matches (rateHz, shape, sampleRate))
+            return clock.get();
+
+    clocks.push_back (std::unique_ptr<SharedLfoClock> (new SharedLfoClock (rateHz, shape, sampleRate)));
+    return clocks.back().get();
+}
+
+SharedLfoClock::SharedLfoClock (int clockRateHz, LfoShape clockShape, double clockSampleRate)
+    : rateHz (clockRateHz),
+      shape (clockShape),
+      sampleRate (clockSampleRate),
+      phaseIncrement (juce::MathConstants<double>::twoPi * clockRateHz / clockSampleRate)
+{
+}
+
+//==============================================================================
+void SharedLfoClock::subscribe (Subscription& subscription) const noexcept
+{
+    for (;;)
+    {
+        const auto latest = published.load (std::memory_order_acquire);
+        const auto& block = blocks[latest % 2];
+        const auto before = block.sequence.load (std::memory_order_acquire);
+
+        if ((before & 1) != 0 || block.generation != latest)
+            continue;
+
+        const auto endPhase = advance (block.startPhase, block.numSamples);
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (block.sequence.load (std::memory_order_relaxed) == before)
+        {
+            subscription.lastGeneration = latest;
+            subscription.endPhase = endPhase;
+            return;
+        }
+    }
+}
+
+double SharedLfoClock::read (Subscription& subscription, float* destination, int numSamples) noexcept
+{
+    jassert (numSamples <= maxBlockSize);
+
+    for (;;)
+    {
+        const auto latest = published.load (std::memory_order_acquire);
+
+        // Another subscriber already moved the clock on for this callback.
+        if (latest > subscription.lastGeneration)
+        {
+            double startPhase;
+
+            if (! readBlock (latest, destination, numSamples, startPhase))
+                continue;
+
+            subscription.lastGeneration = latest;
+            subscription.endPhase = advance (startPhase, numSamples);
+            return subscription.endPhase;
+        }
+
+        break;
+    }
+
+    // Nobody has produced the next block yet. Whoever claims it publishes it;
+    // anyone who loses the race, or who is ahead of a subscriber still writing
+    // the previous block, computes the identical values without waiting.
+    const auto startPhase = subscription.endPhase;
+    const auto next = subscription.lastGeneration + 1;
+    auto expected = subscription.lastGeneration;
+
+    if (published.load (std::memory_order_acquire) == expected
+         && claimed.compare_exchange_strong (expected, next, std::memory_order_acq_rel))
+    {
+        auto& block = blocks[next % 2];
+        const auto sequence = block.sequence.load (std::memory_order_relaxed);
+
+        block.sequence.store (sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        block.generation = next;
+        block.startPhase = startPhase;
+        block.numSamples = numSamples;
+        compute (startPhase, block.values, numSamples);
+
+        block.sequence.store (sequence + 2, std::memory_order_release);
+        published.store (next, std::memory_order_release);
+
+        std::copy (block.values, block.values + numSamples, destination);
+    }
+    else
+    {
+        compute (startPhase, destination, numSamples);
+    }
+
+    subscription.lastGeneration = next;
+    subscription.endPhase = advance (startPhase, numSamples);
+    return subscription.endPhase;
+}
+
+//==============================================================================
+void SharedLfoClock::compute (double startPhase, float* destination, int numSamples) const noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        destination[i] = ChorusEngine<float>::getLfoValue (startPhase + phaseIncrement * i, shape);
+}
+
+double SharedLfoClock::advance (double startPhase, int numSamples) const noexcept
+{
+    return std::fmod (startPhase + phaseIncrement * numSamples, juce::MathConstants<double>::twoPi);
+}
+
+bool SharedLfoClock::readBlock (uint64_t generation, float* destination, int numSamples, double& startPhase) const noexcept
+{
+    const auto& block = blocks[generation % 2];
+    const auto before = block.sequence.load (std::memory_order_acquire);
+
+    if ((before & 1) != 0 || block.generation != generation)
+        return false;
+
+    startPhase = block.startPhase;
+
+    if (block.numSamples == numSamples)
+        std::copy (block.values, block.values + numSamples, destination);
+    else
+        compute (startPhase, destination, numSamples);
+
+    std::atomic_thread_fence (std::memory_order_acquire);
+    return block.sequence.load (std::memory_order_relaxed) == before;
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    SharedLfoClock.h
+
+    A process-wide LFO that every chorus instance running at the same rate,
+    shape and sample rate can subscribe to. The first subscriber to reach a new
+    audio callback computes the block and publishes it, and the others copy it.
+    All of them get the same phase, and the oscillator is evaluated once per
+    callback instead of once per instance.
+
+    Clocks are never freed. There is one per combination of rate, shape and
+    sample rate used during the life of the process, about 33 kB each, and
+    with whole-Hz rates below 100 that stays a small, bounded number.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusEngine.h"
+
+//==============================================================================
+class SharedLfoClock
+{
+public:
+    /** Blocks longer than this are computed by the subscriber itself. */
+    static constexpr int maxBlockSize = 4096;
+
+    /** Returns the clock for this combination, creating it the first time.
+        Clocks are never destroyed, so the pointer stays valid for the life of
+        the process. Takes a lock and may allocate: call it off the audio thread.
+    */
+    static SharedLfoClock* getInstance (int rateHz, LfoShape shape, double sampleRate);
+
+    /** A fractional rate never matches: clocks only run at whole-Hz rates. */
+    bool matches (double otherRateHz, LfoShape otherShape, double otherSampleRate) const noexcept
+    {
+        return otherRateHz == (double) rateHz && otherShape == shape && otherSampleRate == sampleRate;
+    }
+
+    /** Each subscriber keeps one of these and passes it to read(). */
+    struct Subscription
+    {
+        uint64_t lastGeneration = 0;
+        double endPhase = 0;
+    };
+
+    /** Starts following the clock from its most recent block. */
+    void subscribe (Subscription& subscription) const noexcept;
+
+    //==============================================================================
+    /** Fills destination with this callback's LFO values, computing and
+        publishing them if no other subscriber has yet, and returns the phase
+        at the end of the block. If the shared copy is not ready, or was
+        written for a different block size, it computes the values itself from
+        the same starting phase.
+
+        This is lock-free but not wait-free. No subscriber ever blocks on
+        another, but a copy that overlaps a newer block being published fails
+        its sequence check and is retried. Each retry means the clock moved
+        on, so some subscriber always makes progress, but an unlucky one has
+        no fixed bound on its attempts.
+    */
+    double read (Subscription& subscription, float* destination, int numSamples) noexcept;
+
+private:
+    SharedLfoClock (int clockRateHz, LfoShape clockShape, double clockSampleRate);
+
+    struct Block
+    {
+        std::atomic<uint32_t> sequence { 0 };
+        uint64_t generation = 0;
+        double startPhase = 0;
+        int numSamples = 0;
+        float values[maxBlockSize];
+    };
+
+    void compute (double startPhase, float* destination, int numSamples) const noexcept;
+    double advance (double startPhase, int numSamples) const noexcept;
+    bool readBlock (uint64_t generation, float* destination, int numSamples, double& startPhase) const noexcept;
+
+    const int rateHz;
+    const LfoShape shape;
+    const double sampleRate, phaseIncrement;
+
+    /** The newest generation whose values are complete, and the newest one a
+        subscriber has taken on computing.
+    */
+    std::atomic<uint64_t> published { 0 }, claimed { 0 };
+
+    /** Generation g lives in blocks[g % 2], guarded by a sequence lock. */
+    Block blocks[2];
+
+    JUCE_DECLARE_NON_COPYABLE (SharedLfoClock)
+};
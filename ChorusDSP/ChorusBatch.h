@@ -0,0 +1,341 @@
+/*
+  ==============================================================================
+
+    ChorusBatch.h
+
+    Runs the same chorus over many independent mono streams in one call. All
+    streams share the parameters and the LFO, so every stream reads its delay
+    line at the same position. The delay lines are stored with the stream
+    index fastest ([sample][stream]), which turns each tap into one contiguous
+    load across all streams and lets the inner loops vectorise.
+
+    Per stream, the output matches a mono ChorusEngine fed the same input,
+    recovery from a runaway feedback loop included; Tests/ChorusBatchTest
+    checks this. Like the engine, it doesn't depend on JUCE.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusEngine.h"
+#include "ChorusModulation.h"
+
+namespace chorus
+{
+
+//==============================================================================
+template <typename SampleType>
+class ChorusBatch
+{
+public:
+    //==============================================================================
+    /** Starts with the same parameters as a new ChorusEngine. */
+    ChorusBatch()    { setParameters ({}); }
+
+    //==============================================================================
+    /** Allocates state for numStreams streams. Memory use is roughly
+        numStreams * (maxCentreDelayMs * 1.21 + 10) ms of samples, so keep the
+        centre delay limit as low as the material allows.
+    */
+    void prepare (double newSampleRate, int newMaxBlockSize, int newNumStreams,
+                  double newMaxCentreDelayMs = Engine::maxCentreDelayMs)
+    {
+        assert (newSampleRate > 0 && newMaxBlockSize > 0 && newNumStreams > 0);
+
+        sampleRate = newSampleRate;
+        maxBlockSize = newMaxBlockSize;
+        numStreams = newNumStreams;
+        maxCentreDelayMs = limit (1.0, Engine::maxCentreDelayMs, newMaxCentreDelayMs);
+
+        const auto maxDelayMs = maxCentreDelayMs * Engine::maxVoiceSpread + Engine::maxModulationMs;
+        const auto maxDelaySamples = (int) std::ceil (maxDelayMs * sampleRate / 1000.0) + 4;
+        bufferSize = nextPowerOfTwo (maxDelaySamples);
+        bufferMask = bufferSize - 1;
+        maxReadDelay = (SampleType) (bufferSize - 4);
+
+        delayLines.assign ((size_t) bufferSize * (size_t) numStreams, SampleType (0));
+        lastOutput.assign ((size_t) numStreams, SampleType (0));
+        inputLevels.assign ((size_t) numStreams, SampleType (0));
+        limits.assign ((size_t) numStreams, SampleType (0));
+        wet.assign ((size_t) numStreams, SampleType (0));
+        unhealthy.assign ((size_t) numStreams, 0);
+        lfoBuffer.assign ((size_t) maxBlockSize + 1, SampleType (0));
+        inputTile.assign ((size_t) maxBlockSize * (size_t) numStreams, SampleType (0));
+        outputTile.assign ((size_t) maxBlockSize * (size_t) numStreams, SampleType (0));
+
+        oscillator.setSampleRate (sampleRate);
+        guard.setSampleRate (sampleRate);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill (delayLines.begin(), delayLines.end(), SampleType (0));
+        std::fill (lastOutput.begin(), lastOutput.end(), SampleType (0));
+        std::fill (inputLevels.begin(), inputLevels.end(), SampleType (0));
+        writePosition = 0;
+        oscillator.setPhase (0);
+
+        depth.snap();
+        centreDelay.snap();
+        feedback.snap();
+        mix.snap();
+        voices.snap (numVoices);
+    }
+
+    /** Clears one stream so its slot can be reused for a new input. */
+    void resetStream (int stream) noexcept
+    {
+        assert (stream >= 0 && stream < numStreams);
+
+        clearLoop (stream);
+        inputLevels[(size_t) stream] = 0;
+    }
+
+    int getNumStreams() const noexcept    { return numStreams; }
+
+    /** How many times a stream has been silenced and cleared because its
+        output went non-finite or ran away.
+    */
+    uint32_t getNumRecoveries() const noexcept    { return numRecoveries; }
+
+    //==============================================================================
+    void setRate (SampleType newRateHz)          { oscillator.setRate (newRateHz); }
+    void setDepth (SampleType newDepth)          { depth.target = newDepth * (SampleType) Engine::maxModulationMs; }
+    void setFeedback (SampleType newFeedback)    { feedback.target = newFeedback; }
+    void setMix (SampleType newMix)              { mix.target = newMix; }
+
+    void setCentreDelay (SampleType newDelayMs)
+    {
+        centreDelay.target = limit (static_cast<SampleType> (1.0), (SampleType) maxCentreDelayMs, newDelayMs);
+    }
+
+    void setParameters (const ChorusParameters<SampleType>& newParameters)
+    {
+        setRate (newParameters.rate);
+        setDepth (newParameters.depth);
+        setCentreDelay (newParameters.centreDelay);
+        setFeedback (newParameters.feedback);
+        setMix (newParameters.mix);
+    }
+
+    void setQuality (const ChorusQuality& newQuality) noexcept
+    {
+        interpolation = newQuality.interpolation;
+        numVoices = limit (1, Engine::maxVoices, newQuality.numVoices);
+        modulationInterval = limit (1, 64, newQuality.modulationInterval);
+    }
+
+    void setLfoShape (LfoShape newShape) noexcept    { oscillator.setShape (newShape); }
+
+    //==============================================================================
+    /** input and output hold numSamples frames of numStreams samples each,
+        stream index fastest. They may point to the same memory.
+    */
+    void processInterleaved (const SampleType* input, SampleType* output, int numSamples) noexcept
+    {
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            const auto n = std::min (maxBlockSize, numSamples - start);
+            const auto offset = (size_t) start * (size_t) numStreams;
+
+            processChunk (input + offset, output + offset, n);
+        }
+    }
+
+    /** One pointer per stream. The samples are transposed through a scratch tile
+        so the processing itself still runs across streams.
+    */
+    void process (const SampleType* const* inputs, SampleType* const* outputs, int numSamples) noexcept
+    {
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            const auto n = std::min (maxBlockSize, numSamples - start);
+
+            for (int s = 0; s < numStreams; ++s)
+                for (int i = 0; i < n; ++i)
+                    inputTile[(size_t) i * (size_t) numStreams + (size_t) s] = inputs[s][start + i];
+
+            processChunk (inputTile.data(), outputTile.data(), n);
+
+            for (int s = 0; s < numStreams; ++s)
+                for (int i = 0; i < n; ++i)
+                    outputs[s][start + i] = outputTile[(size_t) i * (size_t) numStreams + (size_t) s];
+        }
+    }
+
+private:
+    using Engine = ChorusEngine<SampleType>;
+
+    //==============================================================================
+    void processChunk (const SampleType* input, SampleType* output, int n) noexcept
+    {
+        depth.begin (n);
+        centreDelay.begin (n);
+        feedback.begin (n);
+        mix.begin (n);
+        voices.begin (numVoices, n);
+        oscillator.generate (lfoBuffer.data(), n, modulationInterval);
+
+        const auto streams = (size_t) numStreams;
+        const auto msToSamples = (SampleType) (sampleRate / 1000.0);
+        const auto minDelay = std::max (SampleType (2), msToSamples);
+        const auto* directions = Engine::voiceDirections[0];
+        auto* lines = delayLines.data();
+        auto* last = lastOutput.data();
+        auto* sum = wet.data();
+        auto* bad = unhealthy.data();
+        auto* ceiling = limits.data();
+
+        // Each stream's limit for the chunk, from its input peak, as the
+        // engine works it out for a channel.
+        std::fill (limits.begin(), limits.end(), SampleType (0));
+
+        for (int i = 0; i < n; ++i)
+            for (size_t s = 0; s < streams; ++s)
+                ceiling[s] = std::max (ceiling[s], std::abs (input[(size_t) i * streams + s]));
+
+        for (size_t s = 0; s < streams; ++s)
+            ceiling[s] = guard.update (inputLevels[s], ceiling[s], n);
+
+        for (int i = 0; i < n; ++i)
+        {
+            const auto* x = input + (size_t) i * streams;
+            auto* y = output + (size_t) i * streams;
+            auto* writeRow = lines + (size_t) writePosition * streams;
+
+            for (size_t s = 0; s < streams; ++s)
+            {
+                writeRow[s] = x[s] - last[s];
+                sum[s] = 0;
+            }
+
+            const auto centre = centreDelay.at (i);
+            const auto modulation = depth.at (i) * lfoBuffer[(size_t) i];
+
+            for (int v = 0; v < voices.active; ++v)
+            {
+                auto delay = (centre * Engine::voiceSpread[v] + directions[v] * modulation) * msToSamples;
+                delay = limit (minDelay, maxReadDelay, delay);
+
+                accumulateTap (sum, delay, voices.at (v, i));
+            }
+
+            const auto fb = feedback.at (i);
+            const auto wetAmount = mix.at (i);
+
+            for (size_t s = 0; s < streams; ++s)
+            {
+                bad[s] |= (int) ! isHealthy (sum[s], ceiling[s]);
+                last[s] = sum[s] * fb;
+                y[s] = x[s] + wetAmount * (sum[s] - x[s]);
+            }
+
+            writePosition = (writePosition + 1) & bufferMask;
+        }
+
+        voices.end (numVoices);
+
+        for (size_t s = 0; s < streams; ++s)
+        {
+            if (bad[s] != 0)
+                recoverStream ((int) s, output, n);
+            else
+                last[s] = flushDenormal (last[s]);
+
+            bad[s] = 0;
+        }
+    }
+
+    /** Clears a stream whose feedback loop has blown up and silences the chunk
+        it produced, as ChorusEngine does for a channel.
+    */
+    void recoverStream (int stream, SampleType* output, int n) noexcept
+    {
+        clearLoop (stream);
+
+        for (int i = 0; i < n; ++i)
+            output[(size_t) i * (size_t) numStreams + (size_t) stream] = 0;
+
+        ++numRecoveries;
+    }
+
+    /** Empties a stream's delay line and feedback path. Its input level is
+        left alone, as a recovering engine channel keeps its own.
+    */
+    void clearLoop (int stream) noexcept
+    {
+        for (int row = 0; row < bufferSize; ++row)
+            delayLines[(size_t) row * (size_t) numStreams + (size_t) stream] = 0;
+
+        lastOutput[(size_t) stream] = 0;
+    }
+
+    /** Adds gain * delayLine[delay] to sum for every stream. The interpolation
+        weights are the same for all streams, so they are worked out once.
+    */
+    void accumulateTap (SampleType* sum, SampleType delay, SampleType gain) const noexcept
+    {
+        const auto streams = (size_t) numStreams;
+        const auto delayInt = (int) delay;
+        const auto frac = delay - (SampleType) delayInt;
+        const auto index = writePosition - delayInt;
+        const auto* lines = delayLines.data();
+
+        auto row = [&] (int offset)    { return lines + (size_t) ((index + offset) & bufferMask) * streams; };
+
+        // The same arithmetic, in the same order, as ChorusEngine::read().
+        if (interpolation == ChorusInterpolation::linear)
+        {
+            const auto* a = row (0);
+            const auto* b = row (-1);
+
+            for (size_t s = 0; s < streams; ++s)
+                sum[s] += gain * (a[s] + frac * (b[s] - a[s]));
+
+            return;
+        }
+
+        const auto d = frac + SampleType (1);
+        const auto d1 = d - SampleType (1);
+        const auto d2 = d - SampleType (2);
+        const auto d3 = d - SampleType (3);
+
+        const auto c1 = -d1 * d2 * d3 / SampleType (6);
+        const auto c2 = d2 * d3 * SampleType (0.5);
+        const auto c3 = -d1 * d3 * SampleType (0.5);
+        const auto c4 = d1 * d2 / SampleType (6);
+
+        const auto* v0 = row (1);
+        const auto* v1 = row (0);
+        const auto* v2 = row (-1);
+        const auto* v3 = row (-2);
+
+        for (size_t s = 0; s < streams; ++s)
+            sum[s] += gain * (v0[s] * c1 + d * (v1[s] * c2 + v2[s] * c3 + v3[s] * c4));
+    }
+
+    //==============================================================================
+    using Ramp = ParameterRamp<SampleType>;
+
+    double sampleRate = 44100.0, maxCentreDelayMs = Engine::maxCentreDelayMs;
+    int maxBlockSize = 0, numStreams = 0;
+    int bufferSize = 0, bufferMask = 0, writePosition = 0;
+    SampleType maxReadDelay = 0;
+
+    std::vector<SampleType> delayLines, lastOutput, wet, lfoBuffer, inputTile, outputTile;
+    std::vector<SampleType> inputLevels, limits;
+    FeedbackGuard<SampleType> guard;
+    std::vector<int> unhealthy;
+
+    ChorusLfo<SampleType> oscillator;
+    Ramp depth, centreDelay, feedback, mix;
+    VoiceGains<SampleType, Engine::maxVoices> voices;
+    uint32_t numRecoveries = 0;
+
+    ChorusInterpolation interpolation = ChorusInterpolation::linear;
+    int numVoices = 1, modulationInterval = 1;
+};
+
+} // namespace chorus
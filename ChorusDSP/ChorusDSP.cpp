@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    ChorusDSP.cpp
+
+    The library is header-only. This instantiates every member of the engine
+    and the batch for both sample types, so building the ChorusDSP target
+    checks the headers compile on their own, without JUCE.
+
+  ==============================================================================
+*/
+
+#include "ChorusDSP.h"
+
+namespace chorus
+{
+
+template class ChorusEngine<float>;
+template class ChorusEngine<double>;
+
+template class ChorusBatch<float>;
+template class ChorusBatch<double>;
+
+} // namespace chorus
@@ -0,0 +1,20 @@
+/*
+  ==============================================================================
+
+    ChorusDSP.h
+
+    The chorus algorithm as a header-only C++17 library, with no dependency
+    on JUCE or any other framework. Include this and use chorus::ChorusEngine
+    for multichannel streams, or chorus::ChorusBatch for many mono streams
+    that share one set of parameters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusTypes.h"
+#include "ChorusModulation.h"
+#include "ChorusTrace.h"
+#include "ChorusEngine.h"
+#include "ChorusBatch.h"
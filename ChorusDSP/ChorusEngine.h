@@ -0,0 +1,595 @@
+/*
+  ==============================================================================
+
+    ChorusEngine.h
+
+    The chorus DSP core. It takes the same parameters, in the same units, as
+    juce::dsp::Chorus, which it replaced, and with the default ChorusQuality
+    (one voice, linear interpolation, full-rate LFO) and steady parameters it
+    produces the same output; Tests/JuceChorusNullTest checks this. The two
+    differ in how parameter changes are smoothed: here they are ramped across
+    each block rather than over 50 ms.
+
+    ChorusQuality trades cost for fidelity at runtime: interpolation order,
+    number of voices per channel and the rate at which the LFO is evaluated.
+
+    Audio is passed as non-interleaved channel pointers, and nothing here
+    depends on JUCE, so the engine can be embedded anywhere.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusModulation.h"
+#include "ChorusTrace.h"
+
+namespace chorus
+{
+
+struct KernelAccess;
+
+//==============================================================================
+template <typename SampleType>
+class ChorusEngine
+{
+public:
+    static constexpr int maxVoices = 4;
+    static constexpr double maxCentreDelayMs = 100.0;
+
+    /** The modulation swing at full depth, either side of the centre delay. */
+    static constexpr double maxModulationMs = 10.0;
+
+    /** Each voice sits at its own multiple of the centre delay. */
+    static constexpr SampleType voiceSpread[maxVoices] = { SampleType (1.0), SampleType (0.83), SampleType (1.21), SampleType (0.71) };
+
+    /** Which way each voice's delay moves as the LFO rises. The first voice
+        falls on every channel, as the single tap of juce::dsp::Chorus does, and
+        the others alternate. Odd channels flip the extra voices, which is where
+        a multi-voice chorus gets its width. The last row is the right output of
+        processMonoToStereo(), the left one mirrored.
+    */
+    static constexpr SampleType voiceDirections[3][maxVoices] = {
+        { SampleType (-1), SampleType (1),  SampleType (-1), SampleType (1)  },
+        { SampleType (-1), SampleType (-1), SampleType (1),  SampleType (-1) },
+        { SampleType (1),  SampleType (-1), SampleType (1),  SampleType (-1) }
+    };
+
+    /** The largest entry in voiceSpread. */
+    static constexpr double maxVoiceSpread = 1.21;
+
+    //==============================================================================
+    /** Starts with the same parameters as a new juce::dsp::Chorus. */
+    ChorusEngine()    { setParameters ({}); }
+
+    //==============================================================================
+    /** The delay lines are sized for centre delays up to centreDelayLimitMs,
+        and setCentreDelay() is clamped to it.
+    */
+    void prepare (double newSampleRate, int newMaxBlockSize, int newNumChannels, double centreDelayLimitMs = maxCentreDelayMs)
+    {
+        assert (newSampleRate > 0);
+        assert (newMaxBlockSize > 0 && newNumChannels > 0);
+
+        sampleRate = preparedSampleRate = newSampleRate;
+        maxBlockSize = newMaxBlockSize;
+        numChannels = newNumChannels;
+        centreDelayLimit = limit (1.0, maxCentreDelayMs, centreDelayLimitMs);
+
+        const auto maxDelayMs = centreDelayLimit * maxVoiceSpread + maxModulationMs;
+        auto maxDelaySamples = (int) std::ceil (maxDelayMs * sampleRate / 1000.0) + 4;
+        bufferSize = (int) nextPowerOfTwo (maxDelaySamples);
+        bufferMask = bufferSize - 1;
+        maxReadDelay = (SampleType) (bufferSize - 4);
+
+        // A mono engine can still feed two outputs, see processMonoToStereo().
+        delayBuffers.assign ((size_t) (numChannels * bufferSize), SampleType (0));
+        wetBuffers.assign ((size_t) (std::max (numChannels, 2) * maxBlockSize), SampleType (0));
+        lfoBuffer.assign ((size_t) maxBlockSize + 1, SampleType (0));
+        lastOutput.assign ((size_t) numChannels, SampleType (0));
+        inputLevels.assign ((size_t) numChannels, SampleType (0));
+
+        oscillator.setSampleRate (sampleRate);
+        guard.setSampleRate (sampleRate);
+        reset();
+    }
+
+    /** Switches to a different processing rate without reallocating. The new
+        rate must not be higher than the one passed to prepare(), and the delay
+        lines are cleared.
+    */
+    void setSampleRate (double newSampleRate) noexcept
+    {
+        assert (newSampleRate > 0 && newSampleRate <= preparedSampleRate);
+        sampleRate = std::min (newSampleRate, preparedSampleRate);
+        oscillator.setSampleRate (sampleRate);
+        guard.setSampleRate (sampleRate);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill (delayBuffers.begin(), delayBuffers.end(), SampleType (0));
+        std::fill (lastOutput.begin(), lastOutput.end(), SampleType (0));
+        std::fill (inputLevels.begin(), inputLevels.end(), SampleType (0));
+        writePosition = 0;
+        oscillator.setPhase (0);
+
+        depth.snap();
+        centreDelay.snap();
+        feedback.snap();
+        mix.snap();
+        voices.snap (numVoices);
+    }
+
+    //==============================================================================
+    /** LFO rate in Hz. */
+    void setRate (SampleType newRateHz)
+    {
+        assert (newRateHz >= 0 && newRateHz < static_cast<SampleType> (100.0));
+        oscillator.setRate (newRateHz);
+    }
+
+    /** Modulation depth, 0 to 1. */
+    void setDepth (SampleType newDepth)
+    {
+        assert (newDepth >= 0 && newDepth <= static_cast<SampleType> (1.0));
+        depth.target = newDepth * (SampleType) maxModulationMs;
+    }
+
+    /** Centre delay in milliseconds, 1 to the limit given to prepare(). */
+    void setCentreDelay (SampleType newDelayMs)
+    {
+        centreDelay.target = limit (static_cast<SampleType> (1.0), (SampleType) centreDelayLimit, newDelayMs);
+    }
+
+    /** Feedback gain, -1 to 1. */
+    void setFeedback (SampleType newFeedback)
+    {
+        assert (newFeedback >= static_cast<SampleType> (-1.0) && newFeedback <= static_cast<SampleType> (1.0));
+        feedback.target = newFeedback;
+    }
+
+    /** Wet proportion, 0 to 1. */
+    void setMix (SampleType newMix)
+    {
+        assert (newMix >= 0 && newMix <= static_cast<SampleType> (1.0));
+        mix.target = newMix;
+    }
+
+    void setParameters (const ChorusParameters<SampleType>& newParameters)
+    {
+        setRate (newParameters.rate);
+        setDepth (newParameters.depth);
+        setCentreDelay (newParameters.centreDelay);
+        setFeedback (newParameters.feedback);
+        setMix (newParameters.mix);
+    }
+
+    void setQuality (const ChorusQuality& newQuality) noexcept
+    {
+        interpolation = newQuality.interpolation;
+        numVoices = limit (1, maxVoices, newQuality.numVoices);
+        modulationInterval = limit (1, 64, newQuality.modulationInterval);
+    }
+
+    void setLfoShape (LfoShape newShape) noexcept    { oscillator.setShape (newShape); }
+
+    /** The LFO phase in radians at the start of the next block. */
+    void setPhase (double newPhase) noexcept    { oscillator.setPhase (newPhase); }
+    double getPhase() const noexcept            { return oscillator.getPhase(); }
+
+    /** How many times a channel has been silenced and cleared because its
+        output went non-finite or ran away. Safe to read from any thread.
+    */
+    uint32_t getNumRecoveries() const noexcept    { return numRecoveries.load (std::memory_order_relaxed); }
+
+    /** Makes the next call to process() take its LFO from values, one per
+        sample of the block in the range -1 to 1, instead of generating it.
+        The engine's own phase is not advanced for that block.
+    */
+    void setExternalModulation (const SampleType* values) noexcept    { externalModulation = values; }
+
+    /** Reports the modulation, delay, feedback and mix stages of every chunk to
+        sink, or to nothing if it is null. The sink is not owned.
+    */
+    void setTraceSink (TraceSink* sink) noexcept    { traceSink = sink; }
+
+    /** The LFO waveform at a phase in radians, see chorus::getLfoValue(). */
+    static SampleType getLfoValue (double phaseRadians, LfoShape lfoShape) noexcept
+    {
+        return chorus::getLfoValue<SampleType> (phaseRadians, lfoShape);
+    }
+
+    //==============================================================================
+    /** Runs every channel group on the calling thread. */
+    struct SerialDispatch
+    {
+        template <typename Fn>
+        void forEachChannelGroup (int numChannels, int, Fn&& fn) const    { fn (0, numChannels); }
+    };
+
+    /** Processes numChannelsToProcess channels in place. */
+    void process (SampleType* const* channels, int numChannelsToProcess, int numSamples) noexcept
+    {
+        process (channels, numChannelsToProcess, numSamples, SerialDispatch{});
+    }
+
+    /** Copies each input to its output unless they are the same buffer, then
+        processes the outputs in place.
+    */
+    void process (const SampleType* const* inputs, SampleType* const* outputs, int numChannelsToProcess, int numSamples) noexcept
+    {
+        for (int channel = 0; channel < numChannelsToProcess; ++channel)
+            if (inputs[channel] != outputs[channel])
+                std::memcpy (outputs[channel], inputs[channel], (size_t) numSamples * sizeof (SampleType));
+
+        process (outputs, numChannelsToProcess, numSamples, SerialDispatch{});
+    }
+
+    /** Channels only share read-only state while a chunk is processed, so the
+        dispatcher is free to hand disjoint channel ranges to other threads. It
+        must have finished all of them by the time forEachChannelGroup returns.
+    */
+    template <typename Dispatcher>
+    void process (SampleType* const* channels, int numChannelsToProcess, int numSamples, Dispatcher&& dispatcher) noexcept
+    {
+        assert (numChannelsToProcess <= numChannels);
+
+        const auto* external = externalModulation;
+        externalModulation = nullptr;
+
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            const auto n = std::min (maxBlockSize, numSamples - start);
+
+            beginChunk (n);
+
+            const auto* lfo = external != nullptr ? external + start : lfoBuffer.data();
+
+            if (external == nullptr)
+            {
+                ScopedTrace trace (traceSink, TraceStage::modulation);
+                generateModulation (n);
+            }
+
+            dispatcher.forEachChannelGroup (numChannelsToProcess, n, [&] (int firstChannel, int lastChannel)
+            {
+                for (int channel = firstChannel; channel < lastChannel; ++channel)
+                    processChannel (channel, channels[channel] + start, lfo, n);
+            });
+
+            endChunk (n);
+        }
+    }
+
+    /** Feeds one input into a single delay line and produces two outputs from
+        oppositely modulated taps, the same spread a stereo engine gives its two
+        channels. The engine only needs to be prepared for one channel. left may
+        be the same buffer as input.
+    */
+    void processMonoToStereo (const SampleType* input, SampleType* left, SampleType* right, int numSamples) noexcept
+    {
+        assert (numChannels >= 1);
+
+        const auto* external = externalModulation;
+        externalModulation = nullptr;
+
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            const auto n = std::min (maxBlockSize, numSamples - start);
+
+            beginChunk (n);
+
+            const auto* lfo = external != nullptr ? external + start : lfoBuffer.data();
+
+            if (external == nullptr)
+            {
+                ScopedTrace trace (traceSink, TraceStage::modulation);
+                generateModulation (n);
+            }
+
+            processMonoChunk (input + start, left + start, right + start, lfo, n);
+            endChunk (n);
+        }
+    }
+
+    /** The bypassed path: only writes the input into the delay lines and moves
+        the LFO on, so the engine can be switched back in without the taps
+        reading stale audio. No modulation, interpolation or mixing is done.
+    */
+    void pushBypassed (const SampleType* const* channels, int numInputChannels, int numSamples) noexcept
+    {
+        assert (numInputChannels <= numChannels);
+
+        for (int channel = 0; channel < numInputChannels; ++channel)
+        {
+            auto* buffer = delayBuffers.data() + channel * bufferSize;
+            const auto* input = channels[channel];
+            auto position = writePosition;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                buffer[position] = input[i];
+                position = (position + 1) & bufferMask;
+            }
+
+            lastOutput[(size_t) channel] = 0;
+        }
+
+        writePosition = (writePosition + numSamples) & bufferMask;
+        oscillator.advance (numSamples);
+    }
+
+    /** Takes over from another engine mid-stream: copies its parameters, LFO
+        phase and feedback state, and as much of its delay history as fits,
+        resampled if the two run at different rates. Both engines must be
+        prepared, and nothing is allocated, so this can run on the audio thread.
+    */
+    void warmFrom (const ChorusEngine& other) noexcept
+    {
+        const auto ratio = other.sampleRate / sampleRate;
+        const auto length = std::min (bufferSize, (int) ((double) (other.bufferSize - 2) / ratio));
+        const auto channels = std::min (numChannels, other.numChannels);
+
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            auto* buffer = delayBuffers.data() + channel * bufferSize;
+            const auto* source = other.delayBuffers.data() + channel * other.bufferSize;
+
+            for (int j = 0; j < length; ++j)
+            {
+                const auto delay = (double) j * ratio;
+                const auto delayInt = (int) delay;
+                const auto frac = (SampleType) (delay - (double) delayInt);
+                const auto a = source[(other.writePosition - 1 - delayInt) & other.bufferMask];
+                const auto b = source[(other.writePosition - 2 - delayInt) & other.bufferMask];
+
+                buffer[(writePosition - 1 - j) & bufferMask] = a + frac * (b - a);
+            }
+
+            lastOutput[(size_t) channel] = other.lastOutput[(size_t) channel];
+            inputLevels[(size_t) channel] = other.inputLevels[(size_t) channel];
+        }
+
+        oscillator = other.oscillator;
+        oscillator.setSampleRate (sampleRate);
+        depth = other.depth;
+        feedback = other.feedback;
+        mix = other.mix;
+        centreDelay = other.centreDelay;
+        centreDelay.target = std::min (centreDelay.target, (SampleType) centreDelayLimit);
+
+        interpolation = other.interpolation;
+        numVoices = other.numVoices;
+        modulationInterval = other.modulationInterval;
+        voices = other.voices;
+
+        numRecoveries.store (other.getNumRecoveries(), std::memory_order_relaxed);
+    }
+
+private:
+    /** Lets Benchmarks/KernelBenchmarks time the private stages one at a time. */
+    friend struct KernelAccess;
+
+    //==============================================================================
+    void beginChunk (int n) noexcept
+    {
+        depth.begin (n);
+        centreDelay.begin (n);
+        feedback.begin (n);
+        mix.begin (n);
+        voices.begin (numVoices, n);
+    }
+
+    void endChunk (int n) noexcept
+    {
+        writePosition = (writePosition + n) & bufferMask;
+        voices.end (numVoices);
+    }
+
+    /** Fills lfoBuffer with the modulation for the next n samples and moves
+        the phase on.
+    */
+    void generateModulation (int n) noexcept
+    {
+        oscillator.generate (lfoBuffer.data(), n, modulationInterval);
+    }
+
+    void processChannel (int channel, SampleType* samples, const SampleType* lfo, int n) noexcept
+    {
+        auto* buffer = delayBuffers.data() + channel * bufferSize;
+        auto* wet = wetBuffers.data() + channel * maxBlockSize;
+        const auto msToSamples = (SampleType) (sampleRate / 1000.0);
+        const auto* directions = voiceDirections[channel & 1];
+        auto last = lastOutput[(size_t) channel];
+        auto position = writePosition;
+
+        {
+            ScopedTrace trace (traceSink, TraceStage::delay, channel);
+
+            for (int i = 0; i < n; ++i)
+            {
+                buffer[position] = samples[i] - last;
+
+                const auto sum = sumVoices (buffer, position, i, depth.at (i) * lfo[i], directions, msToSamples);
+
+                wet[i] = sum;
+                last = sum * feedback.at (i);
+                position = (position + 1) & bufferMask;
+            }
+        }
+
+        {
+            ScopedTrace trace (traceSink, TraceStage::health, channel);
+            const auto limit = guard.update (inputLevels[(size_t) channel], getPeak (samples, n), n);
+
+            if (! isHealthy (wet, n, limit))
+            {
+                recoverChannel (channel, samples, n);
+                return;
+            }
+
+            lastOutput[(size_t) channel] = flushDenormal (last);
+        }
+
+        ScopedTrace trace (traceSink, TraceStage::mix, channel);
+        mixWet (samples, wet, n);
+    }
+
+    /** Blends wet into the dry samples in place, at the ramped mix. */
+    void mixWet (SampleType* samples, const SampleType* wet, int n) const noexcept
+    {
+        for (int i = 0; i < n; ++i)
+            samples[i] += mix.at (i) * (wet[i] - samples[i]);
+    }
+
+    void processMonoChunk (const SampleType* input, SampleType* left, SampleType* right, const SampleType* lfo, int n) noexcept
+    {
+        auto* buffer = delayBuffers.data();
+        auto* wetLeft = wetBuffers.data();
+        auto* wetRight = wetLeft + maxBlockSize;
+        const auto msToSamples = (SampleType) (sampleRate / 1000.0);
+        auto last = lastOutput[0];
+        auto position = writePosition;
+
+        {
+            ScopedTrace trace (traceSink, TraceStage::delay, 0);
+
+            for (int i = 0; i < n; ++i)
+            {
+                buffer[position] = input[i] - last;
+
+                const auto modulation = depth.at (i) * lfo[i];
+                const auto sumLeft = sumVoices (buffer, position, i, modulation, voiceDirections[0], msToSamples);
+                const auto sumRight = sumVoices (buffer, position, i, modulation, voiceDirections[2], msToSamples);
+
+                wetLeft[i] = sumLeft;
+                wetRight[i] = sumRight;
+                last = (sumLeft + sumRight) * SampleType (0.5) * feedback.at (i);
+                position = (position + 1) & bufferMask;
+            }
+        }
+
+        {
+            ScopedTrace trace (traceSink, TraceStage::health, 0);
+            const auto limit = guard.update (inputLevels[0], getPeak (input, n), n);
+
+            if (! (isHealthy (wetLeft, n, limit) && isHealthy (wetRight, n, limit)))
+            {
+                recoverChannel (0, left, n);
+                std::fill (right, right + n, SampleType (0));
+                return;
+            }
+
+            lastOutput[0] = flushDenormal (last);
+        }
+
+        ScopedTrace trace (traceSink, TraceStage::mix, 0);
+
+        for (int i = 0; i < n; ++i)
+        {
+            const auto dry = input[i];
+            const auto wetAmount = mix.at (i);
+
+            right[i] = dry + wetAmount * (wetRight[i] - dry);
+            left[i] = dry + wetAmount * (wetLeft[i] - dry);
+        }
+    }
+
+    /** Clears a channel whose feedback loop has blown up and silences the
+        chunk it produced. Only touches that channel's state, so it is safe to
+        call from whichever thread is processing the channel.
+    */
+    void recoverChannel (int channel, SampleType* samples, int n) noexcept
+    {
+        auto* buffer = delayBuffers.data() + channel * bufferSize;
+
+        std::fill (buffer, buffer + bufferSize, SampleType (0));
+        std::fill (samples, samples + n, SampleType (0));
+        lastOutput[(size_t) channel] = 0;
+        numRecoveries.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    /** The voice taps for one sample, each at its own centre delay and moving
+        in the direction given for it. Like juce::dsp::Chorus, no tap is read
+        from less than 1 ms back.
+    */
+    SampleType sumVoices (const SampleType* buffer, int position, int i, SampleType modulation,
+                          const SampleType* directions, SampleType msToSamples) const noexcept
+    {
+        const auto centre = centreDelay.at (i);
+        const auto minDelay = std::max (SampleType (2), msToSamples);
+        SampleType sum = 0;
+
+        for (int v = 0; v < voices.active; ++v)
+        {
+            auto delay = (centre * voiceSpread[v] + directions[v] * modulation) * msToSamples;
+            delay = limit (minDelay, maxReadDelay, delay);
+
+            sum += voices.at (v, i) * read (buffer, position, delay);
+        }
+
+        return sum;
+    }
+
+    SampleType read (const SampleType* buffer, int position, SampleType delay) const noexcept
+    {
+        const auto delayInt = (int) delay;
+        const auto frac = delay - (SampleType) delayInt;
+        const auto index = position - delayInt;
+
+        if (interpolation == ChorusInterpolation::linear)
+        {
+            const auto a = buffer[index & bufferMask];
+            const auto b = buffer[(index - 1) & bufferMask];
+            return a + frac * (b - a);
+        }
+
+        // Same Lagrange formulation as juce::dsp::DelayLine, centred so the
+        // fractional part lies between the second and third taps.
+        const auto d = frac + SampleType (1);
+        const auto v0 = buffer[(index + 1) & bufferMask];
+        const auto v1 = buffer[index & bufferMask];
+        const auto v2 = buffer[(index - 1) & bufferMask];
+        const auto v3 = buffer[(index - 2) & bufferMask];
+
+        const auto d1 = d - SampleType (1);
+        const auto d2 = d - SampleType (2);
+        const auto d3 = d - SampleType (3);
+
+        const auto c1 = -d1 * d2 * d3 / SampleType (6);
+        const auto c2 = d2 * d3 * SampleType (0.5);
+        const auto c3 = -d1 * d3 * SampleType (0.5);
+        const auto c4 = d1 * d2 / SampleType (6);
+
+        return v0 * c1 + d * (v1 * c2 + v2 * c3 + v3 * c4);
+    }
+
+    //==============================================================================
+    using Ramp = ParameterRamp<SampleType>;
+
+    double sampleRate = 44100.0, preparedSampleRate = 44100.0, centreDelayLimit = maxCentreDelayMs;
+    int maxBlockSize = 0, numChannels = 0;
+    int bufferSize = 0, bufferMask = 0, writePosition = 0;
+    SampleType maxReadDelay = 0;
+
+    std::vector<SampleType> delayBuffers, wetBuffers, lfoBuffer, lastOutput;
+
+    /** Each loop's held input level, which sets how loud it may get. */
+    std::vector<SampleType> inputLevels;
+    FeedbackGuard<SampleType> guard;
+
+    ChorusLfo<SampleType> oscillator;
+    const SampleType* externalModulation = nullptr;
+    TraceSink* traceSink = nullptr;
+    Ramp depth, centreDelay, feedback, mix;
+    VoiceGains<SampleType, maxVoices> voices;
+
+    ChorusInterpolation interpolation = ChorusInterpolation::linear;
+    int numVoices = 1, modulationInterval = 1;
+
+    std::atomic<uint32_t> numRecoveries { 0 };
+};
+
+} // namespace chorus
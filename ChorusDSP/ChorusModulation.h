@@ -0,0 +1,262 @@
+/*
+  ==============================================================================
+
+    ChorusModulation.h
+
+    The pieces of the algorithm that ChorusEngine and ChorusBatch both use:
+    the per-chunk parameter ramps, the LFO, the voice fades and the checks on
+    the feedback loop. There is one copy of each, so the batch can't drift
+    from the engine it is meant to match.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChorusTypes.h"
+
+namespace chorus
+{
+
+//==============================================================================
+/** A parameter that is ramped linearly across each processed chunk. */
+template <typename SampleType>
+struct ParameterRamp
+{
+    SampleType current = 0, target = 0, start = 0, step = 0;
+
+    void begin (int numSamples) noexcept
+    {
+        start = current;
+        step = (target - current) / (SampleType) numSamples;
+        current = target;
+    }
+
+    void snap() noexcept    { current = start = target; step = 0; }
+    SampleType at (int i) const noexcept    { return start + step * (SampleType) i; }
+};
+
+//==============================================================================
+/** The LFO waveform at a phase in radians. Sine and triangle line up, both
+    rising through zero at phase 0.
+*/
+template <typename SampleType>
+SampleType getLfoValue (double phaseRadians, LfoShape shape) noexcept
+{
+    if (shape == LfoShape::sine)
+        return (SampleType) std::sin (phaseRadians);
+
+    auto t = phaseRadians / twoPi;
+    t -= std::floor (t);
+
+    if (t < 0.25)  return (SampleType) (4.0 * t);
+    if (t < 0.75)  return (SampleType) (2.0 - 4.0 * t);
+    return (SampleType) (4.0 * t - 4.0);
+}
+
+/** The chorus LFO: a free-running phase, advanced by whoever renders it. */
+template <typename SampleType>
+class ChorusLfo
+{
+public:
+    void setSampleRate (double newSampleRate) noexcept    { sampleRate = newSampleRate; updatePhaseIncrement(); }
+
+    /** LFO rate in Hz. */
+    void setRate (SampleType newRateHz) noexcept    { rate = newRateHz; updatePhaseIncrement(); }
+
+    void setShape (LfoShape newShape) noexcept    { shape = newShape; }
+
+    /** The phase in radians at the start of the next block. */
+    void setPhase (double newPhase) noexcept
+    {
+        phase = std::fmod (newPhase, twoPi);
+
+        if (phase < 0)
+            phase += twoPi;
+    }
+
+    double getPhase() const noexcept    { return phase; }
+
+    /** Fills lfo with the modulation for the next n samples, evaluating the
+        waveform only every interval samples, and moves the phase on.
+    */
+    void generate (SampleType* lfo, int n, int interval) noexcept
+    {
+        if (interval == 1)
+        {
+            // Accumulated in SampleType and wrapped by subtraction, the way
+            // juce::dsp::Oscillator does it, so that a float engine stays in
+            // step with juce::dsp::Chorus over long renders.
+            const auto wrap = (SampleType) twoPi;
+            const auto increment = wrap / (SampleType) sampleRate * rate;
+            auto p = (SampleType) phase;
+
+            for (int i = 0; i < n; ++i)
+            {
+                lfo[i] = getLfoValue<SampleType> (p, shape);
+                p += increment;
+
+                while (p >= wrap)
+                    p -= wrap;
+            }
+
+            phase = (double) p;
+            return;
+        }
+
+        auto previous = getLfoValue<SampleType> (phase, shape);
+
+        for (int knot = 0; knot < n; knot += interval)
+        {
+            auto next = getLfoValue<SampleType> (phase + phaseIncrement * (knot + interval), shape);
+            auto step = (next - previous) / (SampleType) interval;
+            auto end = std::min (n, knot + interval);
+
+            for (int i = knot; i < end; ++i)
+                lfo[i] = previous + step * (SampleType) (i - knot);
+
+            previous = next;
+        }
+
+        advance (n);
+    }
+
+    /** Moves the phase on by n samples without rendering them. */
+    void advance (int n) noexcept    { phase = std::fmod (phase + phaseIncrement * n, twoPi); }
+
+private:
+    void updatePhaseIncrement() noexcept
+    {
+        if (sampleRate > 0)
+            phaseIncrement = twoPi * (double) rate / sampleRate;
+    }
+
+    double sampleRate = 44100.0, phase = 0, phaseIncrement = 0;
+    SampleType rate = 1;
+    LfoShape shape = LfoShape::sine;
+};
+
+//==============================================================================
+/** The gain of each voice. Voices fade in and out over one chunk, so changing
+    the count never clicks.
+*/
+template <typename SampleType, int maxVoices>
+struct VoiceGains
+{
+    /** Jumps straight to numVoices equal voices. */
+    void snap (int numVoices) noexcept
+    {
+        active = numVoices;
+
+        for (int v = 0; v < maxVoices; ++v)
+        {
+            gains[v].target = v < numVoices ? SampleType (1) / (SampleType) numVoices : SampleType (0);
+            gains[v].snap();
+        }
+    }
+
+    void begin (int numVoices, int n) noexcept
+    {
+        active = std::max (active, numVoices);
+        const auto voiceGain = SampleType (1) / (SampleType) numVoices;
+
+        for (int v = 0; v < maxVoices; ++v)
+        {
+            gains[v].target = v < numVoices ? voiceGain : SampleType (0);
+            gains[v].begin (n);
+        }
+    }
+
+    void end (int numVoices) noexcept    { active = numVoices; }
+
+    SampleType at (int voice, int i) const noexcept    { return gains[voice].at (i); }
+
+    /** The voices that are sounding or fading out in the current chunk. */
+    int active = 1;
+    ParameterRamp<SampleType> gains[(size_t) maxVoices];
+};
+
+//==============================================================================
+/** Decides when a feedback loop has run away. The limit follows the level of
+    the loop's own input rather than sitting at a fixed level, so hot input is
+    never mistaken for a runaway.
+
+    With the voice gains summing to 1 and the feedback below 1, a sane loop
+    can't get more than 1 / (1 - 0.95) = 20 times (26 dB) louder than its
+    input. The limit allows 60 dB. The input level is held and then released
+    at 1 dB a second, more slowly than the longest legitimate tail decays
+    (0.95 per loop of at most about 130 ms, or about 3.4 dB a second), so a
+    tail never outlasts the level that allowed it. A loop that grows while
+    its input is silent trips once it is 60 dB over minReferenceLevel.
+*/
+template <typename SampleType>
+struct FeedbackGuard
+{
+    static constexpr SampleType maxLoopGain = SampleType (1000);
+    static constexpr SampleType minReferenceLevel = SampleType (1.0e-3);
+    static constexpr double releaseDbPerSecond = 1.0;
+
+    void setSampleRate (double sampleRate) noexcept
+    {
+        logReleasePerSample = -releaseDbPerSecond / 20.0 * std::log (10.0) / sampleRate;
+    }
+
+    /** Moves a loop's held input level on by a chunk of n samples whose input
+        peaked at inputPeak, and returns the loudest the chunk's wet signal may
+        be. The level is kept finite, so an infinite input doesn't hold the
+        limit open for good.
+    */
+    SampleType update (SampleType& inputLevel, SampleType inputPeak, int n) const noexcept
+    {
+        const auto released = inputLevel * (SampleType) std::exp (logReleasePerSample * (double) n);
+        inputLevel = std::min (std::max (released, inputPeak), std::numeric_limits<SampleType>::max());
+        return std::min (std::max (inputLevel, minReferenceLevel) * maxLoopGain, std::numeric_limits<SampleType>::max());
+    }
+
+    double logReleasePerSample = 0;
+};
+
+/** The largest magnitude in samples. A NaN is skipped rather than returned. */
+template <typename SampleType>
+SampleType getPeak (const SampleType* samples, int n) noexcept
+{
+    SampleType peak = 0;
+
+    for (int i = 0; i < n; ++i)
+        peak = std::max (peak, std::abs (samples[i]));
+
+    return peak;
+}
+
+/** False for NaN, infinity or anything louder than limit. */
+template <typename SampleType>
+bool isHealthy (SampleType value, SampleType limit) noexcept
+{
+    return std::abs (value) <= limit;
+}
+
+/** True if no sample is unhealthy. It is written as a branch-free OR so the
+    loop vectorises, and a NaN fails the comparison like any other bad value.
+*/
+template <typename SampleType>
+bool isHealthy (const SampleType* samples, int n, SampleType limit) noexcept
+{
+    int unhealthy = 0;
+
+    for (int i = 0; i < n; ++i)
+        unhealthy |= (int) ! isHealthy (samples[i], limit);
+
+    return unhealthy == 0;
+}
+
+template <typename SampleType>
+constexpr SampleType minNormalLevel = SampleType (1.0e-15);
+
+/** Stops a decaying feedback loop from feeding denormals back into the line. */
+template <typename SampleType>
+SampleType flushDenormal (SampleType value) noexcept
+{
+    return std::abs (value) < minNormalLevel<SampleType> ? SampleType (0) : value;
+}
+
+} // namespace chorus
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    ChorusTrace.h
+
+    Trace points for seeing when each stage of a block ran. The engine marks
+    the start and end of its stages on a TraceSink, if one is set; with none
+    set each trace point costs a null check. Timing and storing the events is
+    up to the sink.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace chorus
+{
+
+//==============================================================================
+enum class TraceStage
+{
+    callback,       // the whole host callback, marked by the host side
+    parameters,     // reading the parameters for the block, marked by the host side
+    modulation,     // generating the LFO
+    delay,          // writing and reading the delay lines, feedback included
+    health,         // checking the feedback loop and recovering a runaway one
+    mix,            // blending the wet signal into the dry
+
+    numStages
+};
+
+inline const char* getTraceStageName (TraceStage stage) noexcept
+{
+    switch (stage)
+    {
+        case TraceStage::callback:      return "callback";
+        case TraceStage::parameters:    return "parameters";
+        case TraceStage::modulation:    return "modulation";
+        case TraceStage::delay:         return "delay";
+        case TraceStage::health:        return "health check";
+        case TraceStage::mix:           return "mix";
+        case TraceStage::numStages:     break;
+    }
+
+    return "";
+}
+
+/** Receives the trace points. Calls come from the audio thread, and from the
+    threads that process channels in parallel, so they must not block.
+    channel is -1 for stages that cover every channel.
+*/
+struct TraceSink
+{
+    virtual ~TraceSink() = default;
+
+    virtual void begin (TraceStage stage, int channel) noexcept = 0;
+    virtual void end (TraceStage stage, int channel) noexcept = 0;
+};
+
+/** Marks the enclosing scope as one stage on sink, which may be null. */
+class ScopedTrace
+{
+public:
+    ScopedTrace (TraceSink* traceSink, TraceStage traceStage, int traceChannel = -1) noexcept
+        : sink (traceSink), stage (traceStage), channel (traceChannel)
+    {
+        if (sink != nullptr)
+            sink->begin (stage, channel);
+    }
+
+    ~ScopedTrace() noexcept
+    {
+        if (sink != nullptr)
+            sink->end (stage, channel);
+    }
+
+    ScopedTrace (const ScopedTrace&) = delete;
+    ScopedTrace& operator= (const ScopedTrace&) = delete;
+
+private:
+    TraceSink* const sink;
+    const TraceStage stage;
+    const int channel;
+};
+
+} // namespace chorus
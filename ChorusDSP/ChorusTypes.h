@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    ChorusTypes.h
+
+    The settings shared by ChorusEngine and ChorusBatch, and the few helpers
+    they need. Standard C++17 only: nothing here depends on JUCE.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace chorus
+{
+
+//==============================================================================
+enum class ChorusInterpolation
+{
+    linear,
+    lagrange3rd
+};
+
+enum class LfoShape
+{
+    sine,
+    triangle
+};
+
+/** The knobs that trade CPU for fidelity. None of them allocate, so they can be
+    changed between any two calls to ChorusEngine::process(). The defaults are
+    the juce::dsp::Chorus sound.
+*/
+struct ChorusQuality
+{
+    ChorusInterpolation interpolation = ChorusInterpolation::linear;
+
+    /** Delay taps per channel, 1 to ChorusEngine::maxVoices. */
+    int numVoices = 1;
+
+    /** The LFO is evaluated every this many samples and linearly interpolated
+        in between. 1 means full-rate modulation.
+    */
+    int modulationInterval = 1;
+};
+
+/** Everything the chorus sound depends on, in the same units as
+    juce::dsp::Chorus. Changes are ramped across the next processed block.
+*/
+template <typename SampleType>
+struct ChorusParameters
+{
+    /** LFO rate in Hz, below 100. */
+    SampleType rate = SampleType (1);
+
+    /** Modulation depth, 0 to 1. */
+    SampleType depth = SampleType (0.25);
+
+    /** Centre delay in milliseconds, 1 to 100. */
+    SampleType centreDelay = SampleType (7);
+
+    /** Feedback gain, -1 to 1. */
+    SampleType feedback = SampleType (0);
+
+    /** Wet proportion, 0 to 1. */
+    SampleType mix = SampleType (0.5);
+};
+
+//==============================================================================
+constexpr double twoPi = 6.283185307179586476925286766559;
+
+/** value clamped to [lower, upper], with the arguments in the order of juce::jlimit. */
+template <typename Type>
+constexpr Type limit (Type lower, Type upper, Type value) noexcept
+{
+    return value < lower ? lower : (upper < value ? upper : value);
+}
+
+inline int nextPowerOfTwo (int n) noexcept
+{
+    int power = 1;
+
+    while (power < n)
+        power <<= 1;
+
+    return power;
+}
+
+} // namespace chorus
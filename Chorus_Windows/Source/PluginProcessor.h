@@ -1,82 +0,0 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-
-#define rateSliderId "rate"
-#define rateSliderName "Rate"
-
-#define depthSliderId "depth"
-#define depthSliderName "Depth"
-
-#define centerDelaySliderId "center delay"
-#define centerDelaySliderName "Center Delay"
-
-#define feedbackSliderId "feedback"
-#define feedbackSliderName "Feedback"
-
-#define mixSliderId "mix"
-#define mixSliderName "Mix"
-
-
-//==============================================================================
-/**
-*/
-class Chorus_WindowsAudioProcessor : public juce::AudioProcessor
-{
-public:
-    //==============================================================================
-    Chorus_WindowsAudioProcessor();
-    ~Chorus_WindowsAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
-#endif
-
-    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram(int index) override;
-    const juce::String getProgramName(int index) override;
-    void changeProgramName(int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation(juce::MemoryBlock& destData) override;
-    void setStateInformation(const void* data, int sizeInBytes) override;
-    float scaleRange(const float& input, const float& inputLow, const float& inputHigh, const float& outputLow, const float& outputHigh);
-
-    juce::AudioProcessorValueTreeState treeState;
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-
-private:
-
-    juce::dsp::Chorus<float> Chorus_WindowsProcessor;
-
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Chorus_WindowsAudioProcessor)
-};
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    ChorusBatchTest.cpp
+
+    Runs ChorusBatch next to one mono ChorusEngine per stream, with the same
+    input and the same parameter changes, and fails if any output sample of
+    any stream differs by more than a rounding error. The cases cover every
+    quality setting, both LFO shapes, ramped parameter and voice-count
+    changes, a stream whose feedback loop has to be recovered, and a hot
+    stream that must not be mistaken for one.
+
+  ==============================================================================
+*/
+
+#include "ChorusDSP.h"
+
+#include <cstdio>
+#include <limits>
+#include <random>
+
+namespace
+{
+    struct Case
+    {
+        const char* name;
+        chorus::ChorusQuality quality, changedQuality;
+        chorus::LfoShape shape;
+        chorus::ChorusParameters<float> parameters, changedParameters;
+
+        /** Feeds stream 1 this much gain for one block midway. An infinite
+            gain has to trip a recovery; any finite one is just hot input and
+            must not.
+        */
+        float burstGain = 1.0f;
+    };
+
+    constexpr float maxDifference = 1.0e-5f;
+    constexpr int numStreams = 5;
+
+    /** The largest difference between the batch and the engines. */
+    float runCase (const Case& c, double sampleRate, int blockSize, double seconds)
+    {
+        chorus::ChorusBatch<float> batch;
+        batch.setParameters (c.parameters);
+        batch.setQuality (c.quality);
+        batch.setLfoShape (c.shape);
+        batch.prepare (sampleRate, blockSize, numStreams);
+
+        std::vector<chorus::ChorusEngine<float>> engines (numStreams);
+
+        for (auto& engine : engines)
+        {
+            engine.setParameters (c.parameters);
+            engine.setQuality (c.quality);
+            engine.setLfoShape (c.shape);
+            engine.prepare (sampleRate, blockSize, 1);
+        }
+
+        std::vector<std::vector<float>> input ((size_t) numStreams, std::vector<float> ((size_t) blockSize));
+        auto expected = input, actual = input;
+        std::vector<const float*> inputs;
+        std::vector<float*> outputs;
+
+        for (int s = 0; s < numStreams; ++s)
+        {
+            inputs.push_back (input[(size_t) s].data());
+            outputs.push_back (actual[(size_t) s].data());
+        }
+
+        std::mt19937 random (1);
+        std::uniform_real_distribution<float> noise (-0.5f, 0.5f);
+
+        const auto numBlocks = (int) (seconds * sampleRate) / blockSize;
+        float worst = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            if (block == numBlocks / 3)
+            {
+                batch.setParameters (c.changedParameters);
+                batch.setQuality (c.changedQuality);
+
+                for (auto& engine : engines)
+                {
+                    engine.setParameters (c.changedParameters);
+                    engine.setQuality (c.changedQuality);
+                }
+            }
+
+            for (int s = 0; s < numStreams; ++s)
+            {
+                const auto gain = s == 1 && block == numBlocks / 2 ? c.burstGain : 1.0f;
+
+                for (auto& sample : input[(size_t) s])
+                    sample = noise (random) * gain;
+
+                expected[(size_t) s] = input[(size_t) s];
+                auto* channel = expected[(size_t) s].data();
+                engines[(size_t) s].process (&channel, 1, blockSize);
+            }
+
+            batch.process (inputs.data(), outputs.data(), blockSize);
+
+            for (int s = 0; s < numStreams; ++s)
+                for (int i = 0; i < blockSize; ++i)
+                    worst = std::max (worst, std::abs (actual[(size_t) s][(size_t) i] - expected[(size_t) s][(size_t) i]));
+        }
+
+        uint32_t engineRecoveries = 0;
+
+        for (auto& engine : engines)
+            engineRecoveries += engine.getNumRecoveries();
+
+        if (batch.getNumRecoveries() != engineRecoveries)
+        {
+            std::printf ("recoveries differ: batch %u, engines %u\n", batch.getNumRecoveries(), engineRecoveries);
+            return 1.0f;
+        }
+
+        if (std::isinf (c.burstGain) && engineRecoveries == 0)
+        {
+            std::printf ("the burst didn't trip a recovery\n");
+            return 1.0f;
+        }
+
+        if (std::isfinite (c.burstGain) && engineRecoveries != 0)
+        {
+            std::printf ("hot input tripped %u recoveries\n", engineRecoveries);
+            return 1.0f;
+        }
+
+        return worst;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    using chorus::ChorusInterpolation;
+    using chorus::LfoShape;
+
+    const chorus::ChorusQuality plain, rich { ChorusInterpolation::lagrange3rd, 4, 1 }, cheap { ChorusInterpolation::linear, 3, 8 };
+
+    const Case cases[] = {
+        { "defaults",            plain, plain, LfoShape::sine,     {},                                   {} },
+        { "lagrange, 4 voices",  rich,  rich,  LfoShape::sine,     { 3.0f, 1.0f, 2.0f, 0.9f, 0.5f },     { 3.0f, 1.0f, 2.0f, 0.9f, 0.5f } },
+        { "interval 8, triangle", cheap, cheap, LfoShape::triangle, { 0.5f, 0.6f, 20.0f, -0.7f, 1.0f },   { 0.5f, 0.6f, 20.0f, -0.7f, 1.0f } },
+        { "ramps and voices",    plain, rich,  LfoShape::sine,     { 1.0f, 0.25f, 7.0f, 0.0f, 0.5f },    { 8.0f, 0.9f, 40.0f, 0.95f, 0.8f } },
+        { "voices fading out",   rich,  cheap, LfoShape::triangle, { 47.0f, 0.3f, 1.0f, 0.5f, 0.7f },    { 2.0f, 0.1f, 99.0f, -0.3f, 0.2f } },
+        { "hot input",           rich,  rich,  LfoShape::sine,     { 1.0f, 0.25f, 7.0f, 0.95f, 0.5f },   { 1.0f, 0.25f, 7.0f, 0.95f, 0.5f }, 1.0e5f },
+        { "recovery",            plain, plain, LfoShape::sine,     { 1.0f, 0.25f, 7.0f, 0.9f, 0.5f },    { 1.0f, 0.25f, 7.0f, 0.9f, 0.5f }, std::numeric_limits<float>::infinity() }
+    };
+
+    auto failed = false;
+
+    for (auto sampleRate : { 44100.0, 96000.0 })
+    {
+        for (auto blockSize : { 512, 37 })
+        {
+            for (auto& c : cases)
+            {
+                const auto difference = runCase (c, sampleRate, blockSize, 2.0);
+                const auto ok = difference <= maxDifference;
+                failed = failed || ! ok;
+
+                std::printf ("%s  %6.0f Hz  block %3d  %-22s  max difference %.3g\n",
+                             ok ? "ok  " : "FAIL", sampleRate, blockSize, c.name, (double) difference);
+            }
+        }
+    }
+
+    return failed ? 1 : 0;
+}
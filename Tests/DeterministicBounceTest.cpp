@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    DeterministicBounceTest.cpp
+
+    Bounces the same range of a timeline twice with deterministic rendering
+    on, once straight after prepareToPlay and once after playing elsewhere
+    with different settings, and fails unless the two outputs are
+    bit-identical. A bounce starts with a transport jump, which has to leave
+    nothing behind from what was played before it.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Chorus/Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    /** A transport that is always playing, at whatever position it is told. */
+    class TestPlayHead  : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override
+        {
+            PositionInfo info;
+            info.setIsPlaying (true);
+            info.setTimeInSamples (position);
+            return info;
+        }
+
+        juce::int64 position = 0;
+    };
+
+    struct Settings
+    {
+        float rate, depth, centreDelay, feedback, mix;
+    };
+
+    void applySettings (ChorusAudioProcessor& processor, const Settings& settings)
+    {
+        const std::pair<const char*, float> values[] = {
+            { rateSliderId, settings.rate }, { depthSliderId, settings.depth }, { centerDelaySliderId, settings.centreDelay },
+            { feedbackSliderId, settings.feedback }, { mixSliderId, settings.mix }
+        };
+
+        for (const auto& [id, value] : values)
+        {
+            auto* parameter = processor.treeState.getParameter (id);
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+        }
+    }
+
+    /** Plays numBlocks from start, the input being noise that depends only on
+        the position, and returns the output.
+    */
+    juce::AudioBuffer<float> play (ChorusAudioProcessor& processor, TestPlayHead& playHead, juce::int64 start, int numBlocks)
+    {
+        const auto numChannels = processor.getTotalNumOutputChannels();
+        juce::AudioBuffer<float> output (numChannels, numBlocks * blockSize);
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random (start);
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (channel, i, random.nextFloat() - 0.5f);
+
+            playHead.position = start + block * blockSize;
+            processor.processBlock (buffer, midi);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                output.copyFrom (channel, block * blockSize, buffer, channel, 0, blockSize);
+        }
+
+        return output;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ChorusAudioProcessor processor;
+    TestPlayHead playHead;
+    processor.setPlayHead (&playHead);
+    processor.setDeterministicRendering (true);
+    processor.setAdaptiveQualityEnabled (false);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    const Settings bounceSettings { 3.0f, 70.0f, 12.0f, 60.0f, 50.0f };
+    const Settings otherSettings { 9.0f, 10.0f, 40.0f, 90.0f, 100.0f };
+    const juce::int64 bounceStart = 480000;
+    const int numBlocks = 200;
+
+    applySettings (processor, bounceSettings);
+    const auto first = play (processor, playHead, bounceStart, numBlocks);
+
+    applySettings (processor, otherSettings);
+    play (processor, playHead, 12345, numBlocks);
+
+    applySettings (processor, bounceSettings);
+    const auto second = play (processor, playHead, bounceStart, numBlocks);
+
+    int numDifferent = 0;
+
+    for (int channel = 0; channel < first.getNumChannels(); ++channel)
+        for (int i = 0; i < first.getNumSamples(); ++i)
+            if (first.getSample (channel, i) != second.getSample (channel, i))
+                ++numDifferent;
+
+    std::cout << (numDifferent == 0 ? "ok  " : "FAIL") << "  samples that differ between the bounces: " << numDifferent << std::endl;
+
+    processor.setPlayHead (nullptr);
+    return numDifferent == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    JuceChorusNullTest.cpp
+
+    Runs ChorusEngine at its default quality next to the juce::dsp::Chorus it
+    replaced, with the same parameters and the same noise, and fails if the
+    difference between them is more than 60 dB below the output. Parameters
+    are held steady, as the two smooth changes differently.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ChorusEngine.h"
+
+namespace
+{
+    /** Parameters as the plugin feeds them to the engine, in juce::dsp::Chorus units. */
+    struct Case
+    {
+        float rate, depth, centreDelay, feedback, mix;
+    };
+
+    constexpr double maxResidualDb = -60.0;
+
+    /** The residual in dB relative to the reference output. */
+    double runCase (const Case& c, double sampleRate, int blockSize, int numChannels, double seconds)
+    {
+        juce::dsp::Chorus<float> reference;
+        reference.setRate (c.rate);
+        reference.setDepth (c.depth);
+        reference.setCentreDelay (c.centreDelay);
+        reference.setFeedback (c.feedback);
+        reference.setMix (c.mix);
+        reference.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+        chorus::ChorusEngine<float> engine;
+        engine.setParameters ({ c.rate, c.depth, c.centreDelay, c.feedback, c.mix });
+        engine.prepare (sampleRate, blockSize, numChannels);
+
+        juce::AudioBuffer<float> expected (numChannels, blockSize), actual (numChannels, blockSize);
+        juce::Random random (1);
+        double signal = 0, error = 0;
+
+        for (auto remaining = juce::roundToInt (seconds * sampleRate); remaining > 0; remaining -= blockSize)
+        {
+            const auto numSamples = juce::jmin (blockSize, remaining);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    expected.setSample (channel, i, random.nextFloat() - 0.5f);
+
+            actual.makeCopyOf (expected, true);
+
+            juce::dsp::AudioBlock<float> block (expected.getArrayOfWritePointers(), (size_t) numChannels, (size_t) numSamples);
+            reference.process (juce::dsp::ProcessContextReplacing<float> (block));
+            engine.process (actual.getArrayOfWritePointers(), numChannels, numSamples);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto e = (double) expected.getSample (channel, i);
+                    const auto difference = (double) actual.getSample (channel, i) - e;
+                    signal += e * e;
+                    error += difference * difference;
+                }
+            }
+        }
+
+        return 10.0 * std::log10 (error / signal);
+    }
+}
+
+//==============================================================================
+int main()
+{
+    const Case cases[] = {
+        { 1.0f,  0.25f, 7.0f,  0.0f,   0.5f },
+        { 50.0f, 0.0f,  50.0f, 0.0f,   0.0f },
+        { 3.0f,  1.0f,  2.0f,  0.9f,   0.5f },
+        { 1.0f,  0.1f,  30.0f, 0.0f,   1.0f },
+        { 47.0f, 0.3f,  1.0f,  0.95f,  0.7f },
+        { 99.0f, 1.0f,  99.0f, 0.5f,   1.0f }
+    };
+
+    auto failed = false;
+
+    for (auto sampleRate : { 44100.0, 96000.0 })
+    {
+        for (auto blockSize : { 512, 480 })
+        {
+            for (auto& c : cases)
+            {
+                const auto residual = runCase (c, sampleRate, blockSize, 2, 10.0);
+                const auto ok = residual <= maxResidualDb;
+                failed = failed || ! ok;
+
+                std::printf ("%s  %6.0f Hz  block %3d  rate %4.1f depth %.2f centre %4.1f feedback %.2f mix %.2f  residual %7.1f dB\n",
+                             ok ? "ok  " : "FAIL", sampleRate, blockSize,
+                             (double) c.rate, (double) c.depth, (double) c.centreDelay, (double) c.feedback, (double) c.mix, residual);
+            }
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    FileRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "FileRenderer.h"
+
+//==============================================================================
+FileRenderer::FileRenderer (const RenderSettings& s)
+    : settings (s),
+      processor (s.createProcessor())
+{
+    formatManager.registerBasicFormats();
+}
+
+bool FileRenderer::render (const juce::File& input, const juce::File& output, juce::String& error)
+{
+    auto* format = formatManager.findFormatForFileExtension (input.getFileExtension());
+
+    if (format == nullptr)
+    {
+        error = "not an audio file type this build can read";
+        return false;
+    }
+
+    // Decoding straight out of the mapping leaves the reading to the page
+    // cache, with no copy into a stream buffer along the way.
+    juce::MemoryMappedFile mappedFile (input, juce::MemoryMappedFile::readOnly);
+
+    if (mappedFile.getData() == nullptr)
+    {
+        error = "can't map the file";
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader (format->createReaderFor (new juce::MemoryInputStream (mappedFile.getData(), mappedFile.getSize(), false), true));
+
+    if (reader == nullptr)
+    {
+        error = "can't read it as " + format->getFormatName();
+        return false;
+    }
+
+    const auto bitDepths = format->getPossibleBitDepths();
+    const auto bitDepth = bitDepths.contains ((int) reader->bitsPerSample) ? (int) reader->bitsPerSample : bitDepths.getLast();
+
+    if (! output.getParentDirectory().createDirectory())
+    {
+        error = "can't create " + output.getParentDirectory().getFullPathName();
+        return false;
+    }
+
+    output.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream> (output);
+
+    if (stream->failedToOpen())
+    {
+        error = "can't write " + output.getFullPathName();
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), reader->sampleRate, reader->numChannels,
+                                                                              bitDepth, reader->metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        stream.reset();
+        output.deleteFile();
+        error = "can't write " + format->getFormatName() + " at this sample rate and channel count";
+        return false;
+    }
+
+    stream.release();
+
+    if (process (*reader, *writer, error))
+        return true;
+
+    writer.reset();
+    output.deleteFile();
+    return false;
+}
+
+bool FileRenderer::process (juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer, juce::String& error)
+{
+    const auto numChannels = (int) reader.numChannels;
+    const auto blockSize = settings.blockSize;
+
+    if (! settings.prepareProcessor (*processor, reader.sampleRate, numChannels))
+    {
+        error = juce::String (numChannels) + " channels; only 1 to " + juce::String (ChorusAudioProcessor::maxNumChannels) + " are supported";
+        return false;
+    }
+
+    buffer.setSize (numChannels, blockSize, false, false, true);
+
+    // If the render profile oversamples, the filters delay the output. That
+    // much is dropped from the start, and made up by running on past the end.
+    auto samplesToSkip = (juce::int64) processor->getLatencySamples();
+    const auto inputLength = reader.lengthInSamples;
+    const auto tailLength = settings.renderTail ? (juce::int64) std::ceil (processor->getTailLengthSeconds() * reader.sampleRate) : 0;
+    const auto outputLength = inputLength + tailLength;
+
+    for (juce::int64 position = 0, written = 0; written < outputLength; position += blockSize)
+    {
+        buffer.clear();
+
+        if (position < inputLength)
+            reader.read (&buffer, 0, (int) juce::jmin ((juce::int64) blockSize, inputLength - position), position, true, true);
+
+        processor->processBlock (buffer, midi);
+
+        const auto skip = (int) juce::jmin (samplesToSkip, (juce::int64) blockSize);
+        samplesToSkip -= skip;
+
+        const auto numToWrite = (int) juce::jmin ((juce::int64) (blockSize - skip), outputLength - written);
+
+        if (numToWrite > 0 && ! writer.writeFromAudioSampleBuffer (buffer, skip, numToWrite))
+        {
+            error = "writing the output failed";
+            return false;
+        }
+
+        written += numToWrite;
+    }
+
+    secondsRendered += (double) inputLength / reader.sampleRate;
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    FileRenderer.h
+
+    Runs audio files through one ChorusAudioProcessor. Each worker thread in
+    ChorusRender owns one of these, so nothing here is shared between threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "RenderSettings.h"
+
+//==============================================================================
+class FileRenderer
+{
+public:
+    /** Creates the processor, so construct this on the message thread. */
+    explicit FileRenderer (const RenderSettings& settings);
+
+    /** Renders input into output, in the same format and, where the format
+        allows, the same bit depth. The input is memory-mapped and decoded in
+        place. Returns false with a message if anything goes wrong, in which
+        case no output file is left behind.
+    */
+    bool render (const juce::File& input, const juce::File& output, juce::String& error);
+
+    /** Streams everything the reader holds through the processor into the
+        writer, which must have the reader's sample rate and channel count.
+        The output is the length of the input, plus the tail if the settings
+        ask for it, and is aligned with the input despite the processor's
+        latency.
+    */
+    bool process (juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer, juce::String& error);
+
+    /** The duration of all the input rendered so far. */
+    double getSecondsRendered() const noexcept    { return secondsRendered; }
+
+private:
+    const RenderSettings& settings;
+    std::unique_ptr<ChorusAudioProcessor> processor;
+    juce::AudioFormatManager formatManager;
+
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    double secondsRendered = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (FileRenderer)
+};
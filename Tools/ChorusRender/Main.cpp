@@ -0,0 +1,274 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    ChorusRender: runs the chorus over audio files without a host, a display
+    or an audio device. Files are shared out across worker threads, each with
+    a processor of its own. With --pipe it runs as a filter on raw PCM
+    instead, see PipeRenderer.h.
+
+  ==============================================================================
+*/
+
+#include "FileRenderer.h"
+#include "PipeRenderer.h"
+
+namespace
+{
+    const char* const usage =
+        "Usage: ChorusRender [options] --output <dir> <file or dir>...\n"
+        "       ChorusRender [options] --pipe [pipe options]\n"
+        "\n"
+        "Renders every audio file given, and every one found under the directories\n"
+        "given, into the output directory, keeping names and formats. With --pipe,\n"
+        "filters raw interleaved PCM from stdin to stdout instead.\n"
+        "\n"
+        "  -o, --output <dir>      where the rendered files go\n"
+        "  -p, --preset <program>  start from a program, by number or name\n"
+        "  -b, --bank <file>       load a user preset bank before picking the program\n"
+        "  -j, --params <file>     JSON parameter values applied on top of the program\n"
+        "  -t, --threads <n>       worker threads (default: one per core)\n"
+        "      --block-size <n>    samples per processing block, or per frame with --pipe (default: 512)\n"
+        "      --tail              render past the end of each file until the effect has died away\n"
+        "\n"
+        "Pipe options:\n"
+        "      --sample-rate <hz>      (default: 48000)\n"
+        "      --channels <n>          (default: 2)\n"
+        "      --sample-format <fmt>   s16, s24 or f32 (default: f32)\n"
+        "      --control-fd <fd>       read \"<parameter id>=<value>\" lines from this descriptor\n";
+
+    struct Job
+    {
+        juce::File input, output;
+    };
+
+    /** Each input with the place its output goes: the same name in the output
+        directory, under the same subdirectory as it was found in.
+    */
+    bool findJobs (const juce::StringArray& paths, const juce::File& outputDirectory, const juce::String& wildcard,
+                   std::vector<Job>& jobs, juce::String& error)
+    {
+        for (auto& path : paths)
+        {
+            const auto location = juce::File::getCurrentWorkingDirectory().getChildFile (path);
+
+            if (location.isDirectory())
+            {
+                auto files = location.findChildFiles (juce::File::findFiles, true, wildcard);
+                files.sort();
+
+                for (auto& file : files)
+                    jobs.push_back ({ file, outputDirectory.getChildFile (file.getRelativePathFrom (location)) });
+            }
+            else if (location.existsAsFile())
+            {
+                jobs.push_back ({ location, outputDirectory.getChildFile (location.getFileName()) });
+            }
+            else
+            {
+                error = path + " doesn't exist";
+                return false;
+            }
+        }
+
+        for (auto& job : jobs)
+        {
+            if (job.output == job.input)
+            {
+                error = "the output would overwrite " + job.input.getFullPathName();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int runPipe (const RenderSettings& settings, juce::ArgumentList& arguments)
+    {
+        PipeRenderer::StreamFormat format;
+        const auto sampleRate = arguments.removeValueForOption ("--sample-rate");
+        const auto channels = arguments.removeValueForOption ("--channels");
+        const auto sampleFormat = arguments.removeValueForOption ("--sample-format");
+        const auto controlFd = arguments.removeValueForOption ("--control-fd");
+
+        if (sampleRate.isNotEmpty())
+            format.sampleRate = sampleRate.getDoubleValue();
+
+        if (channels.isNotEmpty())
+            format.numChannels = channels.getIntValue();
+
+        if ((sampleFormat.isNotEmpty() && ! PipeRenderer::parseSampleFormat (sampleFormat, format.sampleFormat))
+            || format.sampleRate <= 0 || format.numChannels < 1 || arguments.size() > 0)
+        {
+            std::cerr << usage;
+            return 2;
+        }
+
+        PipeRenderer renderer (settings, format);
+        juce::String error;
+
+        if (! renderer.run (0, 1, controlFd.isNotEmpty() ? controlFd.getIntValue() : -1, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    //==============================================================================
+    class RenderWorker  : public juce::Thread
+    {
+    public:
+        RenderWorker (const RenderSettings& settings, const std::vector<Job>& j, std::atomic<size_t>& next)
+            : juce::Thread ("ChorusRender worker"), renderer (settings), jobs (j), nextJob (next)
+        {
+        }
+
+        void run() override
+        {
+            for (auto index = nextJob++; index < jobs.size(); index = nextJob++)
+            {
+                juce::String error;
+
+                if (! renderer.render (jobs[index].input, jobs[index].output, error))
+                    failures.add (jobs[index].input.getFullPathName() + ": " + error);
+            }
+        }
+
+        FileRenderer renderer;
+        juce::StringArray failures;
+
+    private:
+        const std::vector<Job>& jobs;
+        std::atomic<size_t>& nextJob;
+    };
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.size() == 0 || arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return arguments.size() == 0 ? 2 : 0;
+    }
+
+    RenderSettings settings;
+    settings.preset = arguments.removeValueForOption ("--preset|-p");
+    settings.renderTail = arguments.removeOptionIfFound ("--tail");
+
+    const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+    const auto bankPath = arguments.removeValueForOption ("--bank|-b");
+    const auto parameterPath = arguments.removeValueForOption ("--params|-j");
+
+    if (bankPath.isNotEmpty())
+        settings.bankFile = workingDirectory.getChildFile (bankPath);
+
+    if (parameterPath.isNotEmpty())
+        settings.parameterFile = workingDirectory.getChildFile (parameterPath);
+
+    const auto outputPath = arguments.removeValueForOption ("--output|-o");
+    const auto threadsOption = arguments.removeValueForOption ("--threads|-t");
+    const auto blockSizeOption = arguments.removeValueForOption ("--block-size");
+
+    settings.blockSize = blockSizeOption.isNotEmpty() ? blockSizeOption.getIntValue() : 512;
+
+    juce::String error;
+
+    if (arguments.removeOptionIfFound ("--pipe"))
+    {
+        if (settings.blockSize < 1 || ! settings.resolve (error))
+        {
+            std::cerr << (error.isNotEmpty() ? error : juce::String (usage)) << std::endl;
+            return 2;
+        }
+
+        return runPipe (settings, arguments);
+    }
+
+    juce::StringArray paths;
+
+    for (auto& argument : arguments.arguments)
+    {
+        if (argument.isOption())
+        {
+            std::cerr << "unknown option " << argument.text << "\n\n" << usage;
+            return 2;
+        }
+
+        paths.add (argument.text);
+    }
+
+    if (outputPath.isEmpty() || paths.isEmpty() || settings.blockSize < 1)
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    if (! settings.resolve (error))
+    {
+        std::cerr << error << std::endl;
+        return 2;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    const auto outputDirectory = workingDirectory.getChildFile (outputPath);
+    std::vector<Job> jobs;
+
+    if (! findJobs (paths, outputDirectory, formatManager.getWildcardForAllFormats(), jobs, error))
+    {
+        std::cerr << error << std::endl;
+        return 2;
+    }
+
+    if (jobs.empty())
+    {
+        std::cerr << "no audio files found" << std::endl;
+        return 2;
+    }
+
+    const auto numThreads = juce::jlimit (1, (int) jobs.size(),
+                                          threadsOption.isNotEmpty() ? threadsOption.getIntValue() : juce::SystemStats::getNumCpus());
+
+    // The processors are created here, on the message thread, and only then
+    // handed to the workers.
+    std::atomic<size_t> nextJob { 0 };
+    std::vector<std::unique_ptr<RenderWorker>> workers;
+
+    for (int i = 0; i < numThreads; ++i)
+        workers.push_back (std::make_unique<RenderWorker> (settings, jobs, nextJob));
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (auto& worker : workers)
+        worker->startThread();
+
+    auto secondsRendered = 0.0;
+    juce::StringArray failures;
+
+    for (auto& worker : workers)
+    {
+        worker->waitForThreadToExit (-1);
+        secondsRendered += worker->renderer.getSecondsRendered();
+        failures.addArray (worker->failures);
+    }
+
+    const auto wallSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    for (auto& failure : failures)
+        std::cerr << failure << std::endl;
+
+    std::cout << "files:      " << (int) jobs.size() - failures.size() << " rendered, " << failures.size() << " failed" << std::endl;
+    std::cout << "audio:      " << secondsRendered << " s in " << wallSeconds << " s on " << numThreads << " threads" << std::endl;
+    std::cout << "throughput: " << secondsRendered / wallSeconds << "x realtime, "
+              << secondsRendered / wallSeconds / numThreads << "x per thread" << std::endl;
+
+    return failures.isEmpty() ? 0 : 1;
+}
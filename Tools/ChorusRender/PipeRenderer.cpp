@@ -0,0 +1,311 @@
+/*
+  ==============================================================================
+
+    PipeRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "PipeRenderer.h"
+
+#if ! JUCE_WINDOWS
+ #include <cerrno>
+ #include <csignal>
+ #include <cstring>
+ #include <poll.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    int getBytesPerSample (PipeRenderer::SampleFormat format)
+    {
+        switch (format)
+        {
+            case PipeRenderer::SampleFormat::s16:  return 2;
+            case PipeRenderer::SampleFormat::s24:  return 3;
+            case PipeRenderer::SampleFormat::f32:  return 4;
+        }
+
+        return 4;
+    }
+
+    //==============================================================================
+    using PlanarFloat = juce::AudioData::Pointer<juce::AudioData::Float32, juce::AudioData::NativeEndian,
+                                                 juce::AudioData::NonInterleaved, juce::AudioData::NonConst>;
+
+    template <typename SampleType, typename Endianness>
+    void deinterleave (const char* source, juce::AudioBuffer<float>& destination, int numSamples)
+    {
+        using Interleaved = juce::AudioData::Pointer<SampleType, Endianness, juce::AudioData::Interleaved, juce::AudioData::Const>;
+        const auto numChannels = destination.getNumChannels();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            PlanarFloat (destination.getWritePointer (channel))
+                .convertSamples (Interleaved (source + channel * Interleaved::getBytesPerSample(), numChannels), numSamples);
+    }
+
+    template <typename SampleType, typename Endianness>
+    void interleave (const juce::AudioBuffer<float>& source, char* destination, int numSamples)
+    {
+        using Interleaved = juce::AudioData::Pointer<SampleType, Endianness, juce::AudioData::Interleaved, juce::AudioData::NonConst>;
+        using ConstPlanarFloat = juce::AudioData::Pointer<juce::AudioData::Float32, juce::AudioData::NativeEndian,
+                                                          juce::AudioData::NonInterleaved, juce::AudioData::Const>;
+        const auto numChannels = source.getNumChannels();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            Interleaved (destination + channel * Interleaved::getBytesPerSample(), numChannels)
+                .convertSamples (ConstPlanarFloat (source.getReadPointer (channel)), numSamples);
+    }
+
+   #if ! JUCE_WINDOWS
+    /** Reads until size bytes have arrived or the input ends. Returns the
+        number read, or -1 on an error.
+    */
+    ssize_t readFully (int fd, char* data, size_t size)
+    {
+        size_t total = 0;
+
+        while (total < size)
+        {
+            const auto n = ::read (fd, data + total, size - total);
+
+            if (n == 0)
+                break;
+
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                return -1;
+            }
+
+            total += (size_t) n;
+        }
+
+        return (ssize_t) total;
+    }
+
+    bool writeFully (int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const auto n = ::write (fd, data, size);
+
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                return false;
+            }
+
+            data += n;
+            size -= (size_t) n;
+        }
+
+        return true;
+    }
+   #endif
+}
+
+//==============================================================================
+bool PipeRenderer::parseSampleFormat (const juce::String& text, SampleFormat& result)
+{
+    if (text == "s16")        result = SampleFormat::s16;
+    else if (text == "s24")   result = SampleFormat::s24;
+    else if (text == "f32")   result = SampleFormat::f32;
+    else                      return false;
+
+    return true;
+}
+
+PipeRenderer::PipeRenderer (const RenderSettings& s, const StreamFormat& f)
+    : settings (s),
+      format (f),
+      bytesPerFrameSample (getBytesPerSample (f.sampleFormat) * f.numChannels),
+      processor (s.createProcessor())
+{
+    // Live input, so the processor runs as it would in a live host: no
+    // oversampling, and so no latency beyond the frame itself.
+    processor->setNonRealtime (false);
+
+    frameData.allocate ((size_t) (settings.blockSize * bytesPerFrameSample), true);
+    buffer.setSize (format.numChannels, settings.blockSize);
+}
+
+bool PipeRenderer::run (int inputFd, int outputFd, int newControlFd, juce::String& error)
+{
+   #if JUCE_WINDOWS
+    juce::ignoreUnused (inputFd, outputFd, newControlFd);
+    error = "pipe mode needs a POSIX system";
+    return false;
+   #else
+    if (! settings.prepareProcessor (*processor, format.sampleRate, format.numChannels))
+    {
+        error = "only 1 to " + juce::String (ChorusAudioProcessor::maxNumChannels) + " channels are supported";
+        return false;
+    }
+
+    // Report a closed output as an error from write() rather than being killed.
+    std::signal (SIGPIPE, SIG_IGN);
+
+    controlFd = newControlFd;
+    controlLineLength = 0;
+
+    const auto frameBytes = (size_t) (settings.blockSize * bytesPerFrameSample);
+
+    for (;;)
+    {
+        const auto bytesRead = readFully (inputFd, frameData.get(), frameBytes);
+
+        if (bytesRead < 0)
+        {
+            error = "reading the input failed: " + juce::String (std::strerror (errno));
+            return false;
+        }
+
+        const auto numSamples = (int) ((size_t) bytesRead / (size_t) bytesPerFrameSample);
+
+        if (numSamples == 0)
+            return true;
+
+        readControlMessages();
+        decode (numSamples);
+
+        // Mono float arrives in exactly the layout the processor wants, so the
+        // frame is processed where it was read.
+        float* inPlace[] = { reinterpret_cast<float*> (frameData.get()) };
+        const auto processInPlace = format.sampleFormat == SampleFormat::f32 && format.numChannels == 1;
+
+        juce::AudioBuffer<float> block (processInPlace ? inPlace : buffer.getArrayOfWritePointers(), format.numChannels, numSamples);
+        processor->processBlock (block, midi);
+
+        encode (numSamples);
+
+        if (! writeFully (outputFd, frameData.get(), (size_t) (numSamples * bytesPerFrameSample)))
+        {
+            // A closed output is the normal way for the next process to say it is done.
+            if (errno == EPIPE)
+                return true;
+
+            error = "writing the output failed: " + juce::String (std::strerror (errno));
+            return false;
+        }
+
+        if ((size_t) bytesRead < frameBytes)
+            return true;
+    }
+   #endif
+}
+
+//==============================================================================
+void PipeRenderer::decode (int numSamples)
+{
+    switch (format.sampleFormat)
+    {
+        case SampleFormat::s16:
+            deinterleave<juce::AudioData::Int16, juce::AudioData::LittleEndian> (frameData.get(), buffer, numSamples);
+            break;
+
+        case SampleFormat::s24:
+            deinterleave<juce::AudioData::Int24, juce::AudioData::LittleEndian> (frameData.get(), buffer, numSamples);
+            break;
+
+        case SampleFormat::f32:
+            if (format.numChannels > 1)
+                deinterleave<juce::AudioData::Float32, juce::AudioData::NativeEndian> (frameData.get(), buffer, numSamples);
+
+            break;
+    }
+}
+
+void PipeRenderer::encode (int numSamples)
+{
+    switch (format.sampleFormat)
+    {
+        case SampleFormat::s16:
+            interleave<juce::AudioData::Int16, juce::AudioData::LittleEndian> (buffer, frameData.get(), numSamples);
+            break;
+
+        case SampleFormat::s24:
+            interleave<juce::AudioData::Int24, juce::AudioData::LittleEndian> (buffer, frameData.get(), numSamples);
+            break;
+
+        case SampleFormat::f32:
+            if (format.numChannels > 1)
+                interleave<juce::AudioData::Float32, juce::AudioData::NativeEndian> (buffer, frameData.get(), numSamples);
+
+            break;
+    }
+}
+
+//==============================================================================
+void PipeRenderer::readControlMessages()
+{
+   #if ! JUCE_WINDOWS
+    // The descriptor belongs to whoever started us, so rather than making it
+    // non-blocking, each read waits until poll() says it won't block.
+    while (controlFd >= 0)
+    {
+        pollfd ready { controlFd, POLLIN, 0 };
+        const auto numReady = ::poll (&ready, 1, 0);
+
+        if (numReady < 0 && errno == EINTR)
+            continue;
+
+        if (numReady == 0)
+            return;
+
+        if (numReady < 0 || (ready.revents & POLLNVAL) != 0)
+        {
+            controlFd = -1;
+            return;
+        }
+
+        char data[256];
+        const auto n = ::read (controlFd, data, sizeof (data));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        // The writer has gone away for good.
+        if (n <= 0)
+        {
+            controlFd = -1;
+            return;
+        }
+
+        for (ssize_t i = 0; i < n; ++i)
+        {
+            if (data[i] == '\n')
+            {
+                applyControlMessage (controlLine, controlLineLength);
+                controlLineLength = 0;
+            }
+            else if (controlLineLength < sizeof (controlLine))
+            {
+                controlLine[controlLineLength++] = data[i];
+            }
+        }
+    }
+   #endif
+}
+
+void PipeRenderer::applyControlMessage (const char* text, size_t length)
+{
+    const auto message = juce::String::fromUTF8 (text, (int) length);
+    const auto id = message.upToFirstOccurrenceOf ("=", false, false).trim();
+    const auto value = message.fromFirstOccurrenceOf ("=", false, false).trim();
+
+    auto* parameter = processor->treeState.getParameter (id);
+
+    if (parameter == nullptr || value.isEmpty())
+    {
+        std::cerr << "ignoring control message \"" << message << "\"" << std::endl;
+        return;
+    }
+
+    parameter->setValueNotifyingHost (parameter->convertTo0to1 (value.getFloatValue()));
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    PipeRenderer.h
+
+    ChorusRender's pipe mode: a filter process that reads raw interleaved PCM
+    on one file descriptor and writes the processed PCM, in the same format,
+    to another. Audio moves in frames of a fixed number of samples, and each
+    frame is written out as soon as it has been processed, so the output runs
+    exactly one frame behind the input.
+
+    The processor runs as it does in a live host, so the sound matches the
+    plugin's. Parameters can be changed while running by writing lines of the
+    form
+
+        <parameter id>=<value>
+
+    to the control descriptor, with values in the parameters' own units, for
+    example "center delay=12". Changes take effect from the next frame.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "RenderSettings.h"
+
+//==============================================================================
+class PipeRenderer
+{
+public:
+    enum class SampleFormat
+    {
+        s16,    // 16-bit signed integer, little-endian
+        s24,    // 24-bit signed integer packed in 3 bytes, little-endian
+        f32     // 32-bit float, native byte order
+    };
+
+    struct StreamFormat
+    {
+        double sampleRate = 48000.0;
+        int numChannels = 2;
+        SampleFormat sampleFormat = SampleFormat::f32;
+    };
+
+    /** Parses "s16", "s24" or "f32". */
+    static bool parseSampleFormat (const juce::String& text, SampleFormat& result);
+
+    /** The frame size is RenderSettings::blockSize. Creates the processor, so
+        construct this on the message thread.
+    */
+    PipeRenderer (const RenderSettings& settings, const StreamFormat& format);
+
+    /** Processes frames until the input ends or the output is closed. A short
+        last frame is processed and written as it is. controlFd may be -1.
+        Returns false with a message if reading or writing fails.
+    */
+    bool run (int inputFd, int outputFd, int controlFd, juce::String& error);
+
+private:
+    void readControlMessages();
+    void applyControlMessage (const char* text, size_t length);
+
+    void decode (int numSamples);
+    void encode (int numSamples);
+
+    const RenderSettings& settings;
+    const StreamFormat format;
+    const int bytesPerFrameSample;
+
+    std::unique_ptr<ChorusAudioProcessor> processor;
+    juce::HeapBlock<char> frameData;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+
+    int controlFd = -1;
+    char controlLine[256];
+    size_t controlLineLength = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (PipeRenderer)
+};
@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    RenderSettings.cpp
+
+  ==============================================================================
+*/
+
+#include "RenderSettings.h"
+
+namespace
+{
+    const char* const parameterIds[] = {
+        rateSliderId, depthSliderId, centerDelaySliderId, feedbackSliderId, mixSliderId, morphSliderId
+    };
+
+    bool isParameterId (const juce::String& id)
+    {
+        for (auto* parameterId : parameterIds)
+            if (id == parameterId)
+                return true;
+
+        return false;
+    }
+}
+
+//==============================================================================
+bool RenderSettings::resolve (juce::String& error)
+{
+    parameterValues.clear();
+
+    if (preset.isNotEmpty())
+    {
+        PresetBank bank;
+
+        // The parameter ranges the bank is clamped to come from a processor.
+        if (bankFile != juce::File() && ! bank.loadUserBank (bankFile, ChorusAudioProcessor().getProgramRanges()))
+        {
+            error = bankFile.getFullPathName() + " isn't a preset bank";
+            return false;
+        }
+
+        // A name wins over a number, in case a program is named "1".
+        auto program = -1;
+
+        for (int i = 0; i < bank.getNumPrograms() && program < 0; ++i)
+            if (bank.getProgramName (i).equalsIgnoreCase (preset))
+                program = i;
+
+        if (program < 0 && preset.containsOnly ("0123456789"))
+            program = preset.getIntValue();
+
+        ParameterSnapshot snapshot;
+
+        if (! bank.getSnapshot (program, snapshot))
+        {
+            error = "there is no program \"" + preset + "\"";
+            return false;
+        }
+
+        parameterValues.set (rateSliderId, snapshot.rate);
+        parameterValues.set (depthSliderId, snapshot.depth);
+        parameterValues.set (centerDelaySliderId, snapshot.centreDelay);
+        parameterValues.set (feedbackSliderId, snapshot.feedback);
+        parameterValues.set (mixSliderId, snapshot.mix);
+    }
+
+    if (parameterFile != juce::File())
+    {
+        if (! parameterFile.existsAsFile())
+        {
+            error = parameterFile.getFullPathName() + " doesn't exist";
+            return false;
+        }
+
+        juce::var json;
+        const auto result = juce::JSON::parse (parameterFile.loadFileAsString(), json);
+
+        if (result.failed() || json.getDynamicObject() == nullptr)
+        {
+            error = parameterFile.getFullPathName() + ": " + (result.failed() ? result.getErrorMessage() : "expected an object");
+            return false;
+        }
+
+        for (auto& property : json.getDynamicObject()->getProperties())
+        {
+            const auto id = property.name.toString();
+
+            if (! isParameterId (id))
+            {
+                error = parameterFile.getFullPathName() + ": there is no parameter \"" + id + "\"";
+                return false;
+            }
+
+            if (! (property.value.isInt() || property.value.isInt64() || property.value.isDouble()))
+            {
+                error = parameterFile.getFullPathName() + ": \"" + id + "\" isn't a number";
+                return false;
+            }
+
+            parameterValues.set (property.name, property.value);
+        }
+    }
+
+    return true;
+}
+
+std::unique_ptr<ChorusAudioProcessor> RenderSettings::createProcessor() const
+{
+    auto processor = std::make_unique<ChorusAudioProcessor>();
+    processor->setNonRealtime (true);
+    applyParameters (*processor);
+    return processor;
+}
+
+void RenderSettings::applyParameters (ChorusAudioProcessor& processor) const
+{
+    for (auto* id : parameterIds)
+    {
+        auto* parameter = processor.treeState.getParameter (id);
+
+        if (const auto* value = parameterValues.getVarPointer (id))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 ((float) *value));
+        else
+            parameter->setValueNotifyingHost (parameter->getDefaultValue());
+    }
+}
+
+bool RenderSettings::prepareProcessor (ChorusAudioProcessor& processor, double sampleRate, int numChannels) const
+{
+    if (numChannels < 1)
+        return false;
+
+    // The processor decides which counts it can take: setBusesLayout() asks
+    // its isBusesLayoutSupported().
+    const auto channels = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add (channels);
+    layout.outputBuses.add (channels);
+
+    if (! processor.setBusesLayout (layout))
+        return false;
+
+    processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+    return true;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    RenderSettings.h
+
+    What ChorusRender does to every file: the parameter values, taken from a
+    program and then from a JSON file, and how the processor is run.
+
+    The JSON file is one object whose keys are parameter ids and whose values
+    are in the parameters' own units, as shown on the plugin's knobs:
+
+        { "rate": 2, "depth": 60, "center delay": 12, "feedback": 20, "mix": 50 }
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Chorus/Source/PluginProcessor.h"
+
+//==============================================================================
+struct RenderSettings
+{
+    /** A program number or name, or empty to start from the defaults. */
+    juce::String preset;
+
+    /** A user bank whose programs follow the factory ones. */
+    juce::File bankFile;
+
+    /** Parameter values applied on top of the program. */
+    juce::File parameterFile;
+
+    int blockSize = 512;
+
+    /** Carry on past the end of each input until the effect has died away. */
+    bool renderTail = false;
+
+    //==============================================================================
+    /** Loads the bank and the parameter file and works out the value of every
+        parameter. Returns false with a message if any of them can't be used.
+    */
+    bool resolve (juce::String& error);
+
+    /** A processor set to the resolved values and to offline rendering.
+        Create processors on the message thread.
+    */
+    std::unique_ptr<ChorusAudioProcessor> createProcessor() const;
+
+    /** Sets every parameter of an existing processor: to the resolved value if
+        there is one, otherwise to its default.
+    */
+    void applyParameters (ChorusAudioProcessor& processor) const;
+
+    /** Lays out the buses for numChannels, in and out, in the usual layout
+        for that many channels, and prepares the processor. Returns false if
+        the processor doesn't support the layout.
+    */
+    bool prepareProcessor (ChorusAudioProcessor& processor, double sampleRate, int numChannels) const;
+
+private:
+    juce::NamedValueSet parameterValues;
+};
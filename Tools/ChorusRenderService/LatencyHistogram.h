@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    LatencyHistogram.h
+
+    Counts durations into logarithmic buckets, eight to an octave, from 100 ns
+    to about 100 s. Adding is lock-free, so any number of threads can record
+    into one histogram. Percentiles are accurate to the bucket width, about
+    9%.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()    { reset(); }
+
+    void add (double seconds) noexcept
+    {
+        const auto index = juce::jlimit (0, numBuckets - 1, (int) std::floor (std::log2 (juce::jmax (seconds / minSeconds, 1.0)) * bucketsPerOctave));
+        counts[(size_t) index].fetch_add (1, std::memory_order_relaxed);
+
+        auto previousMax = maxSeconds.load (std::memory_order_relaxed);
+
+        while (seconds > previousMax && ! maxSeconds.compare_exchange_weak (previousMax, seconds, std::memory_order_relaxed)) {}
+    }
+
+    /** Not atomic with respect to concurrent add() calls, which may land on
+        either side of it.
+    */
+    void reset() noexcept
+    {
+        for (auto& count : counts)
+            count.store (0, std::memory_order_relaxed);
+
+        maxSeconds.store (0.0, std::memory_order_relaxed);
+    }
+
+    juce::uint64 getCount() const noexcept
+    {
+        juce::uint64 total = 0;
+
+        for (auto& count : counts)
+            total += count.load (std::memory_order_relaxed);
+
+        return total;
+    }
+
+    /** The upper edge of the bucket holding the given fraction of samples,
+        e.g. 0.99 for the 99th percentile. 0 if nothing has been added.
+    */
+    double getPercentile (double fraction) const noexcept
+    {
+        const auto total = getCount();
+
+        if (total == 0)
+            return 0.0;
+
+        const auto target = (juce::uint64) std::ceil (fraction * (double) total);
+        juce::uint64 seen = 0;
+
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            seen += counts[(size_t) i].load (std::memory_order_relaxed);
+
+            if (seen >= target)
+                return juce::jmin (maxSeconds.load (std::memory_order_relaxed), minSeconds * std::exp2 ((i + 1) / (double) bucketsPerOctave));
+        }
+
+        return maxSeconds.load (std::memory_order_relaxed);
+    }
+
+    double getMaximum() const noexcept    { return maxSeconds.load (std::memory_order_relaxed); }
+
+private:
+    static constexpr double minSeconds = 1.0e-7;
+    static constexpr int bucketsPerOctave = 8;
+    static constexpr int numBuckets = 30 * bucketsPerOctave;
+
+    std::array<std::atomic<juce::uint64>, numBuckets> counts;
+    std::atomic<double> maxSeconds { 0.0 };
+};
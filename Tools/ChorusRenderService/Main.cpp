@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    ChorusRenderService: serves chorus processing to local clients over a
+    Unix-domain socket until interrupted. See RenderService.h.
+
+  ==============================================================================
+*/
+
+#include "RenderService.h"
+
+#include <csignal>
+
+namespace
+{
+    const char* const usage =
+        "Usage: ChorusRenderService [options]\n"
+        "\n"
+        "  -s, --socket <path>         where to listen (default: /tmp/chorus-render.sock)\n"
+        "  -w, --workers <n>           processing threads (default: one per core)\n"
+        "      --warm <n>              engines to prepare up front (default: two per core)\n"
+        "      --batch <n>             most chunks a worker takes at once (default: 8)\n"
+        "      --stats-interval <s>    seconds between statistics lines, 0 for none (default: 10)\n";
+
+    RenderService* runningService = nullptr;
+
+    void handleSignal (int)
+    {
+        if (runningService != nullptr)
+            runningService->stop();
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    RenderService::Options options;
+
+    const auto socketPath = arguments.removeValueForOption ("--socket|-s");
+    const auto workers = arguments.removeValueForOption ("--workers|-w");
+    const auto warm = arguments.removeValueForOption ("--warm");
+    const auto batch = arguments.removeValueForOption ("--batch");
+    const auto statsInterval = arguments.removeValueForOption ("--stats-interval");
+
+    if (socketPath.isNotEmpty())      options.socketPath = socketPath;
+    if (workers.isNotEmpty())         options.numWorkers = workers.getIntValue();
+    if (warm.isNotEmpty())            options.numWarmEngines = warm.getIntValue();
+    if (batch.isNotEmpty())           options.batchSize = batch.getIntValue();
+    if (statsInterval.isNotEmpty())   options.statsIntervalSeconds = statsInterval.getDoubleValue();
+
+    if (arguments.size() > 0 || options.numWorkers < 1 || options.batchSize < 1)
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    RenderService service (options);
+    runningService = &service;
+    std::signal (SIGINT, handleSignal);
+    std::signal (SIGTERM, handleSignal);
+
+    juce::String error;
+    const auto succeeded = service.run (error);
+    runningService = nullptr;
+
+    if (! succeeded)
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
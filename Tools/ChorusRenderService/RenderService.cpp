@@ -0,0 +1,465 @@
+/*
+  ==============================================================================
+
+    RenderService.cpp
+
+  ==============================================================================
+*/
+
+#include "RenderService.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//==============================================================================
+struct RenderService::Session
+{
+    int socket = -1;
+    std::unique_ptr<ChorusAudioProcessor> processor;
+
+    void* memory = nullptr;
+    size_t memorySize = 0;
+    int numChannels = 0, maxChunkSamples = 0;
+    double sampleRate = 0;
+    float* inputs[ServiceProtocol::maxChannels] = {};
+    float* outputs[ServiceProtocol::maxChannels] = {};
+
+    ServiceProtocol::ProcessRequest request;
+    juce::int64 requestTicks = 0;
+
+    /** Set by the main thread when a chunk is queued, cleared by the worker
+        once it has replied.
+    */
+    std::atomic<bool> busy { false };
+};
+
+//==============================================================================
+class RenderService::Worker  : public juce::Thread
+{
+public:
+    explicit Worker (RenderService& s)
+        : juce::Thread ("Chorus render worker"), service (s)
+    {
+        batch.reserve ((size_t) service.options.batchSize);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            batch.clear();
+
+            {
+                std::unique_lock<std::mutex> lock (service.queueLock);
+                service.queueCondition.wait (lock, [this] { return threadShouldExit() || ! service.queue.empty(); });
+
+                while (! service.queue.empty() && (int) batch.size() < service.options.batchSize)
+                {
+                    batch.push_back (service.queue.front());
+                    service.queue.pop_front();
+                }
+            }
+
+            for (auto* session : batch)
+                service.processChunk (*session, midi);
+        }
+    }
+
+private:
+    RenderService& service;
+    std::vector<Session*> batch;
+    juce::MidiBuffer midi;
+};
+
+//==============================================================================
+RenderService::RenderService (const Options& o)
+    : options (o)
+{
+}
+
+RenderService::~RenderService()
+{
+    for (auto& session : sessions)
+        closeSession (*session);
+
+    if (listenSocket >= 0)
+    {
+        ::close (listenSocket);
+        ::unlink (options.socketPath.toRawUTF8());
+    }
+
+    if (wakeFd >= 0)
+        ::close (wakeFd);
+}
+
+void RenderService::stop() noexcept
+{
+    shouldStop = true;
+
+    const juce::uint64 one = 1;
+    juce::ignoreUnused (::write (wakeFd, &one, sizeof (one)));
+}
+
+bool RenderService::run (juce::String& error)
+{
+    wakeFd = ::eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    listenSocket = ::socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if (wakeFd < 0 || listenSocket < 0 || options.socketPath.getNumBytesAsUTF8() >= sizeof (address.sun_path))
+    {
+        error = "can't create a socket at " + options.socketPath;
+        return false;
+    }
+
+    options.socketPath.copyToUTF8 (address.sun_path, sizeof (address.sun_path));
+
+    // A socket file left behind by a previous run would make bind() fail.
+    ::unlink (address.sun_path);
+
+    if (::bind (listenSocket, reinterpret_cast<sockaddr*> (&address), sizeof (address)) != 0
+        || ::listen (listenSocket, 128) != 0)
+    {
+        error = "can't listen on " + options.socketPath + ": " + juce::String (std::strerror (errno));
+        return false;
+    }
+
+    // Constructing and preparing the engines up front means opening a session
+    // only has to re-prepare one that is already allocated.
+    for (int i = 0; i < options.numWarmEngines; ++i)
+    {
+        RenderSettings defaults;
+        auto engine = defaults.createProcessor();
+        defaults.prepareProcessor (*engine, 48000.0, 2);
+        warmEngines.push_back (std::move (engine));
+    }
+
+    for (int i = 0; i < juce::jmax (1, options.numWorkers); ++i)
+    {
+        workers.push_back (std::make_unique<Worker> (*this));
+        workers.back()->startThread();
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<Session*> polledSessions;
+    auto lastStats = juce::Time::getMillisecondCounterHiRes();
+    auto succeeded = true;
+
+    while (! shouldStop)
+    {
+        fds.clear();
+        polledSessions.clear();
+        fds.push_back ({ listenSocket, POLLIN, 0 });
+        fds.push_back ({ wakeFd, POLLIN, 0 });
+
+        for (auto& session : sessions)
+        {
+            if (! session->busy.load (std::memory_order_acquire))
+            {
+                fds.push_back ({ session->socket, POLLIN, 0 });
+                polledSessions.push_back (session.get());
+            }
+        }
+
+        const auto statsIntervalMs = options.statsIntervalSeconds * 1000.0;
+        const auto timeoutMs = statsIntervalMs > 0 ? juce::jmax (0, (int) (lastStats + statsIntervalMs - juce::Time::getMillisecondCounterHiRes()))
+                                                   : -1;
+
+        if (::poll (fds.data(), (nfds_t) fds.size(), timeoutMs) < 0 && errno != EINTR)
+        {
+            error = "poll failed: " + juce::String (std::strerror (errno));
+            succeeded = false;
+            break;
+        }
+
+        if ((fds[1].revents & POLLIN) != 0)
+        {
+            juce::uint64 count;
+            juce::ignoreUnused (::read (wakeFd, &count, sizeof (count)));
+        }
+
+        if ((fds[0].revents & POLLIN) != 0)
+            acceptClient();
+
+        for (size_t i = 0; i < polledSessions.size(); ++i)
+            if (fds[i + 2].revents != 0 && ! handleMessage (*polledSessions[i]))
+                closeSession (*polledSessions[i]);
+
+        sessions.erase (std::remove_if (sessions.begin(), sessions.end(), [] (auto& session) { return session->socket < 0; }),
+                        sessions.end());
+
+        const auto now = juce::Time::getMillisecondCounterHiRes();
+
+        if (statsIntervalMs > 0 && now - lastStats >= statsIntervalMs)
+        {
+            printStats ((now - lastStats) / 1000.0);
+            lastStats = now;
+        }
+    }
+
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    {
+        const std::lock_guard<std::mutex> lock (queueLock);
+        queueCondition.notify_all();
+    }
+
+    for (auto& worker : workers)
+        worker->waitForThreadToExit (-1);
+
+    workers.clear();
+    queue.clear();
+    return succeeded;
+}
+
+//==============================================================================
+void RenderService::acceptClient()
+{
+    const auto socket = ::accept4 (listenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+
+    if (socket < 0)
+        return;
+
+    auto session = std::make_unique<Session>();
+    session->socket = socket;
+    sessions.push_back (std::move (session));
+}
+
+void RenderService::closeSession (Session& session)
+{
+    if (session.processor != nullptr)
+        warmEngines.push_back (std::move (session.processor));
+
+    if (session.memory != nullptr)
+        ::munmap (session.memory, session.memorySize);
+
+    if (session.socket >= 0)
+        ::close (session.socket);
+
+    session.memory = nullptr;
+    session.socket = -1;
+}
+
+bool RenderService::handleMessage (Session& session)
+{
+    alignas (8) char data[ServiceProtocol::maxMessageSize];
+    int fd = -1;
+    const auto size = ServiceProtocol::receive (session.socket, data, sizeof (data), fd);
+
+    if (size <= 0)
+    {
+        if (fd >= 0)
+            ::close (fd);
+
+        return false;
+    }
+
+    switch (ServiceProtocol::getType (data, (size_t) size))
+    {
+        case ServiceProtocol::openRequest:
+        {
+            ServiceProtocol::OpenRequest request;
+            ServiceProtocol::OpenReply reply;
+
+            if ((size_t) size != sizeof (request) || session.processor != nullptr)
+            {
+                if (fd >= 0)
+                    ::close (fd);
+
+                reply.status = ServiceProtocol::badRequest;
+            }
+            else
+            {
+                std::memcpy (&request, data, sizeof (request));
+                reply.status = openSession (session, request, fd);
+
+                if (reply.status == ServiceProtocol::ok)
+                    reply.latencySamples = (juce::uint32) session.processor->getLatencySamples();
+            }
+
+            return ServiceProtocol::send (session.socket, &reply, sizeof (reply));
+        }
+
+        case ServiceProtocol::parameterRequest:
+        {
+            ServiceProtocol::ParameterRequest request;
+
+            if ((size_t) size != sizeof (request) || session.processor == nullptr)
+                return false;
+
+            std::memcpy (&request, data, sizeof (request));
+
+            // The session is idle, so nothing else is using its processor.
+            if (auto* parameter = session.processor->treeState.getParameter (ServiceProtocol::readId (request.id)))
+                parameter->setValueNotifyingHost (parameter->convertTo0to1 (request.value));
+
+            return true;
+        }
+
+        case ServiceProtocol::processRequest:
+        {
+            ServiceProtocol::ProcessRequest request;
+
+            if ((size_t) size != sizeof (request))
+                return false;
+
+            std::memcpy (&request, data, sizeof (request));
+
+            if (session.processor == nullptr || request.numSamples == 0 || (int) request.numSamples > session.maxChunkSamples)
+            {
+                ServiceProtocol::ProcessReply reply;
+                reply.sequence = request.sequence;
+                reply.status = ServiceProtocol::badRequest;
+                return ServiceProtocol::send (session.socket, &reply, sizeof (reply));
+            }
+
+            session.request = request;
+            session.requestTicks = juce::Time::getHighResolutionTicks();
+            session.busy.store (true, std::memory_order_release);
+
+            {
+                const std::lock_guard<std::mutex> lock (queueLock);
+                queue.push_back (&session);
+            }
+
+            queueCondition.notify_one();
+            return true;
+        }
+
+        default:
+            if (fd >= 0)
+                ::close (fd);
+
+            return false;
+    }
+}
+
+juce::uint32 RenderService::openSession (Session& session, const ServiceProtocol::OpenRequest& request, int memoryFd)
+{
+    const auto numChannels = (int) request.numChannels;
+    const auto maxChunk = (int) request.maxChunkSamples;
+    const auto memorySize = ServiceProtocol::getSharedMemorySize (numChannels, maxChunk);
+
+    const auto status = [&]
+    {
+        if (request.protocolVersion != ServiceProtocol::version)
+            return ServiceProtocol::badRequest;
+
+        if (numChannels < 1 || numChannels > ServiceProtocol::maxChannels
+            || maxChunk < 1 || maxChunk > ServiceProtocol::maxChunkSamples
+            || ! (request.sampleRate > 0 && request.sampleRate <= 768000.0))
+            return ServiceProtocol::unsupportedFormat;
+
+        struct stat info;
+
+        if (memoryFd < 0 || ::fstat (memoryFd, &info) != 0 || (size_t) info.st_size < memorySize)
+            return ServiceProtocol::badSharedMemory;
+
+        return ServiceProtocol::ok;
+    }();
+
+    if (status != ServiceProtocol::ok)
+    {
+        if (memoryFd >= 0)
+            ::close (memoryFd);
+
+        return status;
+    }
+
+    RenderSettings settings;
+    settings.preset = ServiceProtocol::readId (request.preset);
+    settings.blockSize = maxChunk;
+    juce::String error;
+
+    if (! settings.resolve (error))
+    {
+        ::close (memoryFd);
+        return ServiceProtocol::unknownPreset;
+    }
+
+    auto* memory = ::mmap (nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    ::close (memoryFd);
+
+    if (memory == MAP_FAILED)
+        return ServiceProtocol::badSharedMemory;
+
+    auto engine = takeEngine();
+    engine->setNonRealtime ((request.flags & ServiceProtocol::offlineQuality) != 0);
+    settings.applyParameters (*engine);
+    settings.prepareProcessor (*engine, request.sampleRate, numChannels);
+
+    session.processor = std::move (engine);
+    session.memory = memory;
+    session.memorySize = memorySize;
+    session.numChannels = numChannels;
+    session.maxChunkSamples = maxChunk;
+    session.sampleRate = request.sampleRate;
+
+    auto* planes = static_cast<float*> (memory);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        session.inputs[channel] = planes + channel * maxChunk;
+        session.outputs[channel] = planes + (numChannels + channel) * maxChunk;
+    }
+
+    return ServiceProtocol::ok;
+}
+
+std::unique_ptr<ChorusAudioProcessor> RenderService::takeEngine()
+{
+    if (warmEngines.empty())
+        return RenderSettings().createProcessor();
+
+    auto engine = std::move (warmEngines.back());
+    warmEngines.pop_back();
+    return engine;
+}
+
+//==============================================================================
+void RenderService::processChunk (Session& session, juce::MidiBuffer& midi)
+{
+    const auto numSamples = (int) session.request.numSamples;
+
+    for (int channel = 0; channel < session.numChannels; ++channel)
+        juce::FloatVectorOperations::copy (session.outputs[channel], session.inputs[channel], numSamples);
+
+    juce::AudioBuffer<float> block (session.outputs, session.numChannels, numSamples);
+    session.processor->processBlock (block, midi);
+
+    ServiceProtocol::ProcessReply reply;
+    reply.sequence = session.request.sequence;
+    ServiceProtocol::send (session.socket, &reply, sizeof (reply));
+
+    latency.add (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - session.requestTicks));
+    chunksProcessed.fetch_add (1, std::memory_order_relaxed);
+    audioMicroseconds.fetch_add ((juce::uint64) (numSamples * 1.0e6 / session.sampleRate), std::memory_order_relaxed);
+
+    // The main thread can read this session's socket again from here on.
+    session.busy.store (false, std::memory_order_release);
+
+    const juce::uint64 one = 1;
+    juce::ignoreUnused (::write (wakeFd, &one, sizeof (one)));
+}
+
+void RenderService::printStats (double elapsedSeconds)
+{
+    const auto chunks = chunksProcessed.exchange (0);
+    const auto audioSeconds = (double) audioMicroseconds.exchange (0) / 1.0e6;
+
+    std::cout << sessions.size() << " sessions, "
+              << juce::roundToInt ((double) chunks / elapsedSeconds) << " chunks/s, "
+              << audioSeconds / elapsedSeconds << "x realtime, latency p50 "
+              << latency.getPercentile (0.5) * 1.0e6 << " us, p99 "
+              << latency.getPercentile (0.99) * 1.0e6 << " us, max "
+              << latency.getMaximum() * 1.0e6 << " us" << std::endl;
+
+    latency.reset();
+}
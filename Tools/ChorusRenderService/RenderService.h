@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    RenderService.h
+
+    A long-lived render daemon. Clients connect over a Unix-domain socket and
+    open sessions; see ServiceProtocol.h for the messages. Each session gets a
+    ChorusAudioProcessor of its own, taken from a pool of engines that were
+    constructed and prepared at start-up, and handed back to the pool when the
+    client goes away.
+
+    The main thread owns the sockets: it accepts clients, opens and closes
+    sessions and reads requests. Chunks to process are queued for a pool of
+    worker threads, which take them in batches of up to batchSize, so that at
+    high load each wake-up does several chunks' worth of work. While a session
+    has a chunk queued or in progress its socket isn't read, so one session's
+    chunks are processed in order and its processor is only ever used by one
+    thread at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ServiceProtocol.h"
+#include "LatencyHistogram.h"
+#include "../ChorusRender/RenderSettings.h"
+
+//==============================================================================
+class RenderService
+{
+public:
+    struct Options
+    {
+        juce::String socketPath = "/tmp/chorus-render.sock";
+        int numWorkers = juce::SystemStats::getNumCpus();
+        int numWarmEngines = 2 * juce::SystemStats::getNumCpus();
+        int batchSize = 8;
+
+        /** How often a line of statistics is printed, or 0 for never. */
+        double statsIntervalSeconds = 10.0;
+    };
+
+    explicit RenderService (const Options& options);
+    ~RenderService();
+
+    /** Listens and serves until stop() is called. Call on the message thread,
+        as processors are created here. Returns false with a message if the
+        socket can't be set up.
+    */
+    bool run (juce::String& error);
+
+    /** Makes run() return. Safe to call from a signal handler. */
+    void stop() noexcept;
+
+private:
+    struct Session;
+    class Worker;
+
+    void acceptClient();
+    void closeSession (Session& session);
+    bool handleMessage (Session& session);
+    juce::uint32 openSession (Session& session, const ServiceProtocol::OpenRequest& request, int memoryFd);
+    void processChunk (Session& session, juce::MidiBuffer& midi);
+    void printStats (double elapsedSeconds);
+
+    std::unique_ptr<ChorusAudioProcessor> takeEngine();
+
+    const Options options;
+    int listenSocket = -1, wakeFd = -1;
+    std::atomic<bool> shouldStop { false };
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<std::unique_ptr<ChorusAudioProcessor>> warmEngines;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex queueLock;
+    std::condition_variable queueCondition;
+    std::deque<Session*> queue;
+
+    /** From a chunk's request arriving to its reply being sent. */
+    LatencyHistogram latency;
+    std::atomic<juce::uint64> chunksProcessed { 0 }, audioMicroseconds { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (RenderService)
+};
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    ServiceClient.cpp
+
+  ==============================================================================
+*/
+
+#include "ServiceClient.h"
+
+#include <sys/mman.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//==============================================================================
+ServiceClient::~ServiceClient()
+{
+    if (socket >= 0)
+        ::close (socket);
+
+    if (planes != nullptr)
+        ::munmap (planes, memorySize);
+}
+
+bool ServiceClient::open (const juce::String& socketPath, const SessionFormat& newFormat, juce::String& error)
+{
+    jassert (socket < 0);
+    format = newFormat;
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    socketPath.copyToUTF8 (address.sun_path, sizeof (address.sun_path));
+
+    socket = ::socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+    if (socket < 0 || ::connect (socket, reinterpret_cast<sockaddr*> (&address), sizeof (address)) != 0)
+    {
+        error = "can't connect to " + socketPath + ": " + juce::String (std::strerror (errno));
+        return false;
+    }
+
+    // An anonymous file: it goes away once both sides have unmapped it.
+    memorySize = ServiceProtocol::getSharedMemorySize (format.numChannels, format.maxChunkSamples);
+    const auto memoryFd = ::memfd_create ("chorus-session", MFD_CLOEXEC);
+
+    if (memoryFd < 0 || ::ftruncate (memoryFd, (off_t) memorySize) != 0)
+    {
+        if (memoryFd >= 0)
+            ::close (memoryFd);
+
+        error = "can't create the shared memory: " + juce::String (std::strerror (errno));
+        return false;
+    }
+
+    auto* memory = ::mmap (nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+
+    if (memory == MAP_FAILED)
+    {
+        ::close (memoryFd);
+        error = "can't map the shared memory: " + juce::String (std::strerror (errno));
+        return false;
+    }
+
+    planes = static_cast<float*> (memory);
+
+    ServiceProtocol::OpenRequest request;
+    request.sampleRate = format.sampleRate;
+    request.numChannels = (juce::uint32) format.numChannels;
+    request.maxChunkSamples = (juce::uint32) format.maxChunkSamples;
+    request.flags = format.offlineQuality ? (juce::uint32) ServiceProtocol::offlineQuality : 0u;
+    ServiceProtocol::copyId (request.preset, format.preset);
+
+    const auto sent = ServiceProtocol::send (socket, &request, sizeof (request), memoryFd);
+    ::close (memoryFd);
+
+    ServiceProtocol::OpenReply reply;
+    int unusedFd = -1;
+
+    if (! sent || ServiceProtocol::receive (socket, &reply, sizeof (reply), unusedFd) != (ssize_t) sizeof (reply))
+    {
+        error = "the service closed the connection";
+        return false;
+    }
+
+    if (reply.status != ServiceProtocol::ok)
+    {
+        error = "the service refused the session (status " + juce::String (reply.status) + ")";
+        return false;
+    }
+
+    latencySamples = (int) reply.latencySamples;
+    return true;
+}
+
+bool ServiceClient::process (int numSamples)
+{
+    ServiceProtocol::ProcessRequest request;
+    request.sequence = ++sequence;
+    request.numSamples = (juce::uint32) numSamples;
+
+    if (! ServiceProtocol::send (socket, &request, sizeof (request)))
+        return false;
+
+    ServiceProtocol::ProcessReply reply;
+    int unusedFd = -1;
+
+    return ServiceProtocol::receive (socket, &reply, sizeof (reply), unusedFd) == (ssize_t) sizeof (reply)
+        && reply.sequence == sequence
+        && reply.status == ServiceProtocol::ok;
+}
+
+bool ServiceClient::setParameter (const juce::String& id, float value)
+{
+    ServiceProtocol::ParameterRequest request;
+    request.value = value;
+    ServiceProtocol::copyId (request.id, id);
+
+    return ServiceProtocol::send (socket, &request, sizeof (request));
+}
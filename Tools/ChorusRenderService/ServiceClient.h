@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    ServiceClient.h
+
+    One session with ChorusRenderService: connects, sets up the shared memory
+    for the audio and sends chunks one at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ServiceProtocol.h"
+
+//==============================================================================
+class ServiceClient
+{
+public:
+    struct SessionFormat
+    {
+        double sampleRate = 48000.0;
+        int numChannels = 2;
+        int maxChunkSamples = 512;
+        bool offlineQuality = false;
+
+        /** A program number or name, or empty for the defaults. */
+        juce::String preset;
+    };
+
+    ServiceClient() = default;
+    ~ServiceClient();
+
+    /** Returns false with a message if the service can't be reached or
+        refuses the session.
+    */
+    bool open (const juce::String& socketPath, const SessionFormat& format, juce::String& error);
+
+    /** Where to put the next chunk's input, maxChunkSamples long. */
+    float* getInput (int channel) const noexcept            { return planes + channel * format.maxChunkSamples; }
+
+    /** The last chunk's output, once process() has returned. */
+    const float* getOutput (int channel) const noexcept     { return planes + (format.numChannels + channel) * format.maxChunkSamples; }
+
+    /** Processes the first numSamples of the input, and waits for the output. */
+    bool process (int numSamples);
+
+    /** Takes effect from the next chunk. */
+    bool setParameter (const juce::String& id, float value);
+
+    int getLatencySamples() const noexcept    { return latencySamples; }
+
+private:
+    SessionFormat format;
+    int socket = -1;
+    float* planes = nullptr;
+    size_t memorySize = 0;
+    juce::uint32 sequence = 0;
+    int latencySamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (ServiceClient)
+};
@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    ServiceLoad.cpp
+
+    ChorusServiceLoad: measures a running ChorusRenderService under load. For
+    each client count in turn, that many clients each open a session and send
+    chunks back to back for a while. Reported per client count: chunks per
+    second, audio throughput as a multiple of realtime, and the round-trip
+    latency of a chunk as the client sees it.
+
+  ==============================================================================
+*/
+
+#include "ServiceClient.h"
+#include "LatencyHistogram.h"
+
+namespace
+{
+    const char* const usage =
+        "Usage: ChorusServiceLoad [options]\n"
+        "\n"
+        "  -s, --socket <path>     the service's socket (default: /tmp/chorus-render.sock)\n"
+        "  -c, --clients <list>    client counts to try, comma separated (default: 1,2,4,8,16,32)\n"
+        "      --seconds <s>       how long each count runs (default: 5)\n"
+        "      --chunk <n>         samples per chunk (default: 512)\n"
+        "      --sample-rate <hz>  (default: 48000)\n"
+        "      --offline           ask for the offline quality profile\n";
+
+    class LoadClient  : public juce::Thread
+    {
+    public:
+        LoadClient (const juce::String& path, const ServiceClient::SessionFormat& f, LatencyHistogram& h)
+            : juce::Thread ("Chorus load client"), socketPath (path), format (f), histogram (h)
+        {
+        }
+
+        void run() override
+        {
+            ServiceClient client;
+
+            if (! client.open (socketPath, format, error))
+                return;
+
+            for (int channel = 0; channel < format.numChannels; ++channel)
+                for (int i = 0; i < format.maxChunkSamples; ++i)
+                    client.getInput (channel)[i] = 0.5f * (float) std::sin (0.05 * i);
+
+            while (! threadShouldExit())
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                if (! client.process (format.maxChunkSamples))
+                {
+                    error = "a chunk failed";
+                    return;
+                }
+
+                histogram.add (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+                ++numChunks;
+            }
+        }
+
+        juce::String error;
+        juce::int64 numChunks = 0;
+
+    private:
+        const juce::String socketPath;
+        const ServiceClient::SessionFormat format;
+        LatencyHistogram& histogram;
+    };
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    auto socketPath = arguments.removeValueForOption ("--socket|-s");
+    auto clientList = arguments.removeValueForOption ("--clients|-c");
+    const auto secondsOption = arguments.removeValueForOption ("--seconds");
+    const auto chunkOption = arguments.removeValueForOption ("--chunk");
+    const auto sampleRateOption = arguments.removeValueForOption ("--sample-rate");
+
+    ServiceClient::SessionFormat format;
+    format.offlineQuality = arguments.removeOptionIfFound ("--offline");
+
+    if (socketPath.isEmpty())          socketPath = "/tmp/chorus-render.sock";
+    if (clientList.isEmpty())          clientList = "1,2,4,8,16,32";
+    if (chunkOption.isNotEmpty())      format.maxChunkSamples = chunkOption.getIntValue();
+    if (sampleRateOption.isNotEmpty()) format.sampleRate = sampleRateOption.getDoubleValue();
+
+    const auto seconds = secondsOption.isNotEmpty() ? secondsOption.getDoubleValue() : 5.0;
+
+    if (arguments.size() > 0 || format.maxChunkSamples < 1 || format.sampleRate <= 0 || seconds <= 0)
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    const auto chunkSeconds = format.maxChunkSamples / format.sampleRate;
+
+    std::cout << "chunk: " << format.maxChunkSamples << " samples (" << chunkSeconds * 1000.0 << " ms), "
+              << format.numChannels << " channels" << std::endl;
+    std::cout << "clients   chunks/s   x realtime   p50 us   p99 us   max us" << std::endl;
+
+    for (auto& count : juce::StringArray::fromTokens (clientList, ",", {}))
+    {
+        const auto numClients = count.getIntValue();
+
+        if (numClients < 1)
+            continue;
+
+        LatencyHistogram histogram;
+        std::vector<std::unique_ptr<LoadClient>> clients;
+
+        for (int i = 0; i < numClients; ++i)
+            clients.push_back (std::make_unique<LoadClient> (socketPath, format, histogram));
+
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (auto& client : clients)
+            client->startThread();
+
+        juce::Thread::sleep (juce::roundToInt (seconds * 1000.0));
+
+        for (auto& client : clients)
+            client->signalThreadShouldExit();
+
+        juce::int64 numChunks = 0;
+
+        for (auto& client : clients)
+        {
+            client->waitForThreadToExit (-1);
+            numChunks += client->numChunks;
+
+            if (client->error.isNotEmpty())
+            {
+                std::cerr << client->error << std::endl;
+                return 1;
+            }
+        }
+
+        const auto elapsed = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        std::cout << juce::String (numClients).paddedLeft (' ', 7)
+                  << juce::String ((double) numChunks / elapsed, 0).paddedLeft (' ', 11)
+                  << juce::String ((double) numChunks * chunkSeconds / elapsed, 1).paddedLeft (' ', 13)
+                  << juce::String (histogram.getPercentile (0.5) * 1.0e6, 0).paddedLeft (' ', 9)
+                  << juce::String (histogram.getPercentile (0.99) * 1.0e6, 0).paddedLeft (' ', 9)
+                  << juce::String (histogram.getMaximum() * 1.0e6, 0).paddedLeft (' ', 9) << std::endl;
+    }
+
+    return 0;
+}
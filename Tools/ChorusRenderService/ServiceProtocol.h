@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    ServiceProtocol.h
+
+    The messages between ChorusRenderService and its clients. They travel over
+    a Unix-domain SOCK_SEQPACKET socket, so every send arrives as one whole
+    message. Audio never goes over the socket: each session has a shared
+    memory block, created by the client and passed with its open request,
+    laid out as
+
+        float input[numChannels][maxChunkSamples]
+        float output[numChannels][maxChunkSamples]
+
+    A session goes:
+
+        client                          service
+        OpenRequest + memory fd   ->
+                                  <-    OpenReply
+        (fill input)
+        ProcessRequest            ->
+                                  <-    ProcessReply    (output is ready)
+        ...
+        close the socket
+
+    ParameterRequests can be sent between chunks and apply from the next one.
+    A client sends its next ProcessRequest only after the previous reply; the
+    service doesn't read from a session while its chunk is being processed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace ServiceProtocol
+{
+    constexpr juce::uint32 version = 1;
+    constexpr int maxChannels = 2;
+    constexpr int maxChunkSamples = 1 << 16;
+    constexpr int idLength = 32;
+
+    enum MessageType : juce::uint32
+    {
+        openRequest = 1,
+        openReply,
+        processRequest,
+        processReply,
+        parameterRequest
+    };
+
+    enum Status : juce::uint32
+    {
+        ok = 0,
+        badRequest,
+        unsupportedFormat,
+        unknownPreset,
+        badSharedMemory
+    };
+
+    enum OpenFlags : juce::uint32
+    {
+        /** Render with the offline quality profile, as ChorusRender does. */
+        offlineQuality = 1
+    };
+
+    //==============================================================================
+    struct OpenRequest
+    {
+        juce::uint32 type = openRequest;
+        juce::uint32 protocolVersion = version;
+        double sampleRate = 48000.0;
+        juce::uint32 numChannels = 2;
+        juce::uint32 maxChunkSamples = 512;
+        juce::uint32 flags = 0;
+
+        /** A program number or name, zero padded, or empty for the defaults. */
+        char preset[idLength] = {};
+    };
+
+    struct OpenReply
+    {
+        juce::uint32 type = openReply;
+        juce::uint32 status = ok;
+
+        /** How far the output trails the input, in samples. */
+        juce::uint32 latencySamples = 0;
+    };
+
+    struct ProcessRequest
+    {
+        juce::uint32 type = processRequest;
+        juce::uint32 sequence = 0;
+        juce::uint32 numSamples = 0;
+    };
+
+    struct ProcessReply
+    {
+        juce::uint32 type = processReply;
+        juce::uint32 sequence = 0;
+        juce::uint32 status = ok;
+    };
+
+    struct ParameterRequest
+    {
+        juce::uint32 type = parameterRequest;
+
+        /** In the parameter's own units. */
+        float value = 0.0f;
+
+        /** A parameter id, zero padded. */
+        char id[idLength] = {};
+    };
+
+    /** Large enough for any of the messages above. */
+    constexpr size_t maxMessageSize = 64;
+
+    inline size_t getSharedMemorySize (int numChannels, int maxChunk) noexcept
+    {
+        return 2 * (size_t) numChannels * (size_t) maxChunk * sizeof (float);
+    }
+
+    //==============================================================================
+    /** Sends one message, with a file descriptor attached if fd isn't -1. */
+    inline bool send (int socket, const void* data, size_t size, int fd = -1)
+    {
+        iovec io { const_cast<void*> (data), size };
+        msghdr message {};
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+
+        alignas (cmsghdr) char control[CMSG_SPACE (sizeof (int))] = {};
+
+        if (fd >= 0)
+        {
+            message.msg_control = control;
+            message.msg_controllen = sizeof (control);
+
+            auto* header = CMSG_FIRSTHDR (&message);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type = SCM_RIGHTS;
+            header->cmsg_len = CMSG_LEN (sizeof (int));
+            std::memcpy (CMSG_DATA (header), &fd, sizeof (int));
+        }
+
+        for (;;)
+        {
+            const auto sent = ::sendmsg (socket, &message, MSG_NOSIGNAL);
+
+            if (sent >= 0)
+                return (size_t) sent == size;
+
+            if (errno != EINTR)
+                return false;
+        }
+    }
+
+    /** Receives one message. Returns its size, 0 if the peer has closed the
+        connection, or -1 on an error. A descriptor sent along with it is
+        stored in fd, which is otherwise set to -1.
+    */
+    inline ssize_t receive (int socket, void* data, size_t capacity, int& fd)
+    {
+        iovec io { data, capacity };
+        msghdr message {};
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+
+        alignas (cmsghdr) char control[CMSG_SPACE (sizeof (int))] = {};
+        message.msg_control = control;
+        message.msg_controllen = sizeof (control);
+
+        fd = -1;
+
+        for (;;)
+        {
+            const auto received = ::recvmsg (socket, &message, MSG_CMSG_CLOEXEC);
+
+            if (received < 0 && errno == EINTR)
+                continue;
+
+            if (received > 0)
+                for (auto* header = CMSG_FIRSTHDR (&message); header != nullptr; header = CMSG_NXTHDR (&message, header))
+                    if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+                        std::memcpy (&fd, CMSG_DATA (header), sizeof (int));
+
+            return received;
+        }
+    }
+
+    /** The type field every message starts with. */
+    inline juce::uint32 getType (const void* data, size_t size) noexcept
+    {
+        juce::uint32 type = 0;
+
+        if (size >= sizeof (type))
+            std::memcpy (&type, data, sizeof (type));
+
+        return type;
+    }
+
+    /** The first idLength bytes of text, zero padded. */
+    inline void copyId (char (&destination)[idLength], const juce::String& text) noexcept
+    {
+        std::memset (destination, 0, idLength);
+        text.copyToUTF8 (destination, idLength);
+    }
+
+    inline juce::String readId (const char (&source)[idLength])
+    {
+        return juce::String::fromUTF8 (source, (int) strnlen (source, idLength));
+    }
+}
@@ -0,0 +1,286 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    RealtimeSafetyCheck: drives a ChorusAudioProcessor through the things a
+    host does to it (prepare, automation, varying block sizes, state and
+    program changes, bypass, bus and sample-rate changes, a trip through
+    offline rendering) with every audio callback inside a
+    RealtimeGuard::ScopedAudioCallback. Any allocation, lock, wait or
+    blocking system call made from a callback is printed with a stack trace,
+    and the program exits with status 1, so it can run as a CI step.
+
+    Work the host does on the message thread (prepareToPlay and state
+    changes) is not checked. Parameter and program changes are, as VST3 and
+    CLAP hosts deliver parameters on the audio thread and some hosts change
+    programs there too.
+
+    Pipe the output through c++filt for readable stack traces.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Chorus/Source/PluginProcessor.h"
+#include "RealtimeGuard.h"
+
+namespace
+{
+    const char* const usage =
+        "Usage: RealtimeSafetyCheck [options]\n"
+        "\n"
+        "  -n, --callbacks <n>    callbacks per phase (default: 500)\n"
+        "  -b, --block-size <n>   largest block size (default: 512)\n"
+        "      --abort            abort on the first violation, for a debugger\n";
+
+    using BusesLayout = juce::AudioProcessor::BusesLayout;
+
+    BusesLayout makeLayout (const juce::AudioChannelSet& input, const juce::AudioChannelSet& output)
+    {
+        BusesLayout layout;
+        layout.inputBuses.add (input);
+        layout.outputBuses.add (output);
+        return layout;
+    }
+
+    //==============================================================================
+    class Driver
+    {
+    public:
+        Driver (int callbacksPerPhase, int maxBlockSize)
+            : numCallbacks (callbacksPerPhase), blockSize (maxBlockSize),
+              buffer (2, maxBlockSize), random (1)
+        {
+        }
+
+        /** Runs every phase and returns the number that had a violation. */
+        int run()
+        {
+            prepare (makeLayout (juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo()), 48000.0);
+            runPhase ("the first callbacks after prepare", {});
+
+            runPhase ("automation", { [this] (int)
+            {
+                for (auto* parameter : processor.getParameters())
+                    parameter->setValue (juce::jlimit (0.0f, 1.0f, parameter->getValue() + 0.02f * (random.nextFloat() - 0.5f)));
+            }});
+
+            runPhase ("parameter jumps", { [this] (int callback)
+            {
+                if (callback % 8 == 0)
+                    for (auto* parameter : processor.getParameters())
+                        parameter->setValue (random.nextFloat());
+            }});
+
+            runPhase ("varying block sizes", { {}, {}, true });
+
+            juce::MemoryBlock savedState;
+            processor.getStateInformation (savedState);
+
+            runPhase ("state restores", { {}, [this, &savedState] (int callback)
+            {
+                if (callback % 16 == 0)
+                {
+                    for (auto* parameter : processor.getParameters())
+                        parameter->setValueNotifyingHost (random.nextFloat());
+
+                    processor.setStateInformation (savedState.getData(), (int) savedState.getSize());
+                }
+            }});
+
+            // The switch is made on the audio thread, and the block that picks
+            // it up must not reach for the message thread to update the knobs.
+            runPhase ("program changes", { [this] (int callback)
+            {
+                if (callback % 16 == 0)
+                    processor.setCurrentProgram (random.nextInt (processor.getNumPrograms()));
+            }});
+
+            runPhase ("bypass", { {}, {}, false, true });
+
+            prepare (makeLayout (juce::AudioChannelSet::mono(), juce::AudioChannelSet::mono()), 48000.0);
+            runPhase ("mono buses", {});
+
+            prepare (makeLayout (juce::AudioChannelSet::mono(), juce::AudioChannelSet::stereo()), 48000.0);
+            runPhase ("mono in, stereo out", {});
+
+            prepare (makeLayout (juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo()), 96000.0);
+            runPhase ("96 kHz", {});
+
+            prepare (makeLayout (juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo()), 44100.0);
+            runPhase ("44.1 kHz", {});
+
+            // Offline rendering may allocate, so it isn't checked, but the
+            // switch back to real time is.
+            processor.setNonRealtime (true);
+            prepare (processor.getBusesLayout(), 44100.0);
+            processUnchecked (numCallbacks / 4);
+            processor.setNonRealtime (false);
+            runPhase ("returning from offline rendering", {});
+
+            processor.setDeterministicRendering (true);
+            runPhase ("deterministic rendering", {});
+            processor.setDeterministicRendering (false);
+
+            processor.setSharedModulationClock (true);
+            runPhase ("the shared LFO clock", {});
+            processor.setSharedModulationClock (false);
+
+            return numFailedPhases;
+        }
+
+    private:
+        /** What a phase does besides processing. Both steps are given the
+            callback's index.
+        */
+        struct Phase
+        {
+            /** Runs on the audio thread, inside the guard, before processBlock. */
+            std::function<void (int)> duringCallback;
+
+            /** Runs before each callback, outside the guard, as the message
+                thread would.
+            */
+            std::function<void (int)> betweenCallbacks;
+
+            bool varyBlockSize = false;
+
+            /** Alternates between processBlock and processBlockBypassed every
+                32 callbacks.
+            */
+            bool bypass = false;
+        };
+
+        void prepare (const BusesLayout& layout, double sampleRate)
+        {
+            processor.releaseResources();
+
+            if (! processor.setBusesLayout (layout))
+                std::cerr << "the layout was refused" << std::endl;
+
+            processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+            dispatchMessages();
+        }
+
+        /** Lets the processor's timers and async updates run, as the host's
+            message thread would between callbacks.
+        */
+        static void dispatchMessages()
+        {
+            juce::MessageManager::getInstance()->runDispatchLoopUntil (1);
+        }
+
+        /** Processes numCallbacks blocks and reports whether any broke the rules. */
+        void runPhase (const char* name, const Phase& phase)
+        {
+            const auto violationsBefore = RealtimeGuard::getNumViolations();
+
+            for (int callback = 0; callback < numCallbacks; ++callback)
+            {
+                if (phase.betweenCallbacks)
+                    phase.betweenCallbacks (callback);
+
+                if (callback % 32 == 0)
+                    dispatchMessages();
+
+                const auto numSamples = phase.varyBlockSize ? 1 + random.nextInt (blockSize) : blockSize;
+                fillInput (numSamples);
+
+                juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), getNumChannels(), numSamples);
+
+                RealtimeGuard::ScopedAudioCallback guard (name);
+
+                if (phase.duringCallback)
+                    phase.duringCallback (callback);
+
+                if (phase.bypass && callback % 64 < 32)
+                    processor.processBlockBypassed (block, midi);
+                else
+                    processor.processBlock (block, midi);
+            }
+
+            const auto violations = RealtimeGuard::getNumViolations() - violationsBefore;
+
+            if (violations > 0)
+                ++numFailedPhases;
+
+            std::cout << (violations == 0 ? "ok      " : "FAILED  ") << name;
+
+            if (violations > 0)
+                std::cout << " (" << violations << " violations)";
+
+            std::cout << std::endl;
+        }
+
+        /** Callbacks that are allowed to block, such as offline ones. */
+        void processUnchecked (int count)
+        {
+            for (int callback = 0; callback < count; ++callback)
+            {
+                fillInput (blockSize);
+                juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), getNumChannels(), blockSize);
+                processor.processBlock (block, midi);
+            }
+        }
+
+        int getNumChannels() const
+        {
+            return juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+        }
+
+        void fillInput (int numSamples)
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    buffer.setSample (channel, i, 0.5f * (float) std::sin (0.03 * (double) (position + i)));
+
+            position += numSamples;
+        }
+
+        const int numCallbacks, blockSize;
+        ChorusAudioProcessor processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        juce::Random random;
+        juce::int64 position = 0;
+        int numFailedPhases = 0;
+    };
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    const auto callbacksOption = arguments.removeValueForOption ("--callbacks|-n");
+    const auto blockSizeOption = arguments.removeValueForOption ("--block-size|-b");
+    RealtimeGuard::setAbortOnViolation (arguments.removeOptionIfFound ("--abort"));
+
+    const auto numCallbacks = callbacksOption.isNotEmpty() ? callbacksOption.getIntValue() : 500;
+    const auto blockSize = blockSizeOption.isNotEmpty() ? blockSizeOption.getIntValue() : 512;
+
+    if (arguments.size() > 0 || numCallbacks < 1 || blockSize < 1)
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    RealtimeGuard::initialise();
+
+    Driver driver (numCallbacks, blockSize);
+    const auto numFailedPhases = driver.run();
+
+    std::cout << std::endl << RealtimeGuard::getNumViolations() << " violations in "
+              << numFailedPhases << " phases" << std::endl;
+
+    return numFailedPhases == 0 ? 0 : 1;
+}
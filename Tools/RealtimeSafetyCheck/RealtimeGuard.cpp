@@ -0,0 +1,398 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+
+  ==============================================================================
+*/
+
+// glibc's fortified headers define inline versions of read, open and the
+// like, which would clash with the definitions below.
+#undef _FORTIFY_SOURCE
+
+#include "RealtimeGuard.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void __libc_free (void*);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+}
+
+namespace
+{
+    thread_local int callbackDepth = 0;
+    thread_local bool reporting = false;
+    thread_local const char* currentPhase = "";
+
+    std::atomic<int> numViolations { 0 };
+    std::atomic<bool> abortOnViolation { false };
+
+    void writeToStderr (const char* text) noexcept
+    {
+        auto remaining = std::strlen (text);
+
+        while (remaining > 0)
+        {
+            const auto written = ::write (STDERR_FILENO, text, remaining);
+
+            if (written <= 0)
+                return;
+
+            text += written;
+            remaining -= (size_t) written;
+        }
+    }
+
+    /** Called first thing by every wrapper. Outside a ScopedAudioCallback it
+        does nothing. Inside one it counts the call and prints it, then lets
+        the wrapper carry on, so one run finds every offender. The wrapped
+        functions that the reporting itself calls are let through.
+    */
+    void check (const char* function) noexcept
+    {
+        if (callbackDepth == 0 || reporting)
+            return;
+
+        reporting = true;
+        const auto index = numViolations.fetch_add (1, std::memory_order_relaxed) + 1;
+        const auto shouldAbort = abortOnViolation.load (std::memory_order_relaxed);
+
+        if (index <= RealtimeGuard::maxReportedViolations || shouldAbort)
+        {
+            char heading[256];
+            std::snprintf (heading, sizeof (heading), "\nreal-time violation %d: %s in the audio callback, during %s\n",
+                           index, function, currentPhase);
+            writeToStderr (heading);
+
+            void* frames[64];
+            const auto numFrames = backtrace (frames, 64);
+
+            // Frame 0 is this function.
+            backtrace_symbols_fd (frames + 1, numFrames - 1, STDERR_FILENO);
+
+            if (index == RealtimeGuard::maxReportedViolations && ! shouldAbort)
+                writeToStderr ("\nfurther violations are counted but not printed\n");
+        }
+
+        if (shouldAbort)
+            std::abort();
+
+        reporting = false;
+    }
+
+    /** The next definition of a wrapped function, normally glibc's. A race
+        between two threads only means both look it up.
+    */
+    template <typename Fn>
+    Fn getNext (Fn& cached, const char* name) noexcept
+    {
+        if (cached == nullptr)
+            cached = reinterpret_cast<Fn> (dlsym (RTLD_NEXT, name));
+
+        return cached;
+    }
+}
+
+#define REALTIME_GUARD_NEXT(name) \
+    static decltype (&::name) next_##name = nullptr; \
+    const auto next = getNext (next_##name, #name);
+
+//==============================================================================
+namespace RealtimeGuard
+{
+    void initialise()
+    {
+        // glibc loads libgcc_s the first time it unwinds, which allocates.
+        void* frames[4];
+        backtrace (frames, 4);
+    }
+
+    ScopedAudioCallback::ScopedAudioCallback (const char* phase) noexcept
+        : previousPhase (currentPhase)
+    {
+        currentPhase = phase;
+        ++callbackDepth;
+    }
+
+    ScopedAudioCallback::~ScopedAudioCallback() noexcept
+    {
+        --callbackDepth;
+        currentPhase = previousPhase;
+    }
+
+    void setAbortOnViolation (bool shouldAbort) noexcept
+    {
+        abortOnViolation.store (shouldAbort, std::memory_order_relaxed);
+    }
+
+    int getNumViolations() noexcept
+    {
+        return numViolations.load (std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
+// Memory. operator new and delete come through here too, as libstdc++
+// implements them with malloc and free.
+extern "C"
+{
+    void* malloc (size_t size) noexcept
+    {
+        check ("malloc");
+        return __libc_malloc (size);
+    }
+
+    void free (void* pointer) noexcept
+    {
+        if (pointer != nullptr)
+            check ("free");
+
+        __libc_free (pointer);
+    }
+
+    void* calloc (size_t count, size_t size) noexcept
+    {
+        check ("calloc");
+        return __libc_calloc (count, size);
+    }
+
+    void* realloc (void* pointer, size_t size) noexcept
+    {
+        check ("realloc");
+        return __libc_realloc (pointer, size);
+    }
+
+    void* memalign (size_t alignment, size_t size) noexcept
+    {
+        check ("memalign");
+        return __libc_memalign (alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size) noexcept
+    {
+        check ("aligned_alloc");
+        return __libc_memalign (alignment, size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size) noexcept
+    {
+        check ("posix_memalign");
+
+        if (alignment % sizeof (void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        auto* memory = __libc_memalign (alignment, size);
+
+        if (memory == nullptr)
+            return ENOMEM;
+
+        *result = memory;
+        return 0;
+    }
+
+    //==============================================================================
+    // Locks and waits. Unlocking and trylock never block, so they are left alone.
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        check ("pthread_mutex_lock");
+        REALTIME_GUARD_NEXT (pthread_mutex_lock)
+        return next (mutex);
+    }
+
+    int pthread_rwlock_rdlock (pthread_rwlock_t* lock) noexcept
+    {
+        check ("pthread_rwlock_rdlock");
+        REALTIME_GUARD_NEXT (pthread_rwlock_rdlock)
+        return next (lock);
+    }
+
+    int pthread_rwlock_wrlock (pthread_rwlock_t* lock) noexcept
+    {
+        check ("pthread_rwlock_wrlock");
+        REALTIME_GUARD_NEXT (pthread_rwlock_wrlock)
+        return next (lock);
+    }
+
+    int pthread_cond_wait (pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        check ("pthread_cond_wait");
+        REALTIME_GUARD_NEXT (pthread_cond_wait)
+        return next (condition, mutex);
+    }
+
+    int pthread_cond_timedwait (pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        check ("pthread_cond_timedwait");
+        REALTIME_GUARD_NEXT (pthread_cond_timedwait)
+        return next (condition, mutex, time);
+    }
+
+    int pthread_cond_signal (pthread_cond_t* condition) noexcept
+    {
+        check ("pthread_cond_signal");
+        REALTIME_GUARD_NEXT (pthread_cond_signal)
+        return next (condition);
+    }
+
+    int pthread_cond_broadcast (pthread_cond_t* condition) noexcept
+    {
+        check ("pthread_cond_broadcast");
+        REALTIME_GUARD_NEXT (pthread_cond_broadcast)
+        return next (condition);
+    }
+
+    int sem_wait (sem_t* semaphore)
+    {
+        check ("sem_wait");
+        REALTIME_GUARD_NEXT (sem_wait)
+        return next (semaphore);
+    }
+
+    int sem_timedwait (sem_t* semaphore, const struct timespec* time)
+    {
+        check ("sem_timedwait");
+        REALTIME_GUARD_NEXT (sem_timedwait)
+        return next (semaphore, time);
+    }
+
+    int sem_post (sem_t* semaphore) noexcept
+    {
+        check ("sem_post");
+        REALTIME_GUARD_NEXT (sem_post)
+        return next (semaphore);
+    }
+
+    int pthread_create (pthread_t* thread, const pthread_attr_t* attributes, void* (*start) (void*), void* argument) noexcept
+    {
+        check ("pthread_create");
+        REALTIME_GUARD_NEXT (pthread_create)
+        return next (thread, attributes, start, argument);
+    }
+
+    //==============================================================================
+    // System calls that block, or that mean file or memory-map work.
+    ssize_t read (int fd, void* buffer, size_t size)
+    {
+        check ("read");
+        REALTIME_GUARD_NEXT (read)
+        return next (fd, buffer, size);
+    }
+
+    ssize_t write (int fd, const void* buffer, size_t size)
+    {
+        check ("write");
+        REALTIME_GUARD_NEXT (write)
+        return next (fd, buffer, size);
+    }
+
+    int open (const char* path, int flags, ...)
+    {
+        check ("open");
+        REALTIME_GUARD_NEXT (open)
+
+        va_list arguments;
+        va_start (arguments, flags);
+        const auto mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg (arguments, mode_t) : (mode_t) 0;
+        va_end (arguments);
+
+        return next (path, flags, mode);
+    }
+
+    int openat (int directory, const char* path, int flags, ...)
+    {
+        check ("openat");
+        REALTIME_GUARD_NEXT (openat)
+
+        va_list arguments;
+        va_start (arguments, flags);
+        const auto mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg (arguments, mode_t) : (mode_t) 0;
+        va_end (arguments);
+
+        return next (directory, path, flags, mode);
+    }
+
+    int close (int fd)
+    {
+        check ("close");
+        REALTIME_GUARD_NEXT (close)
+        return next (fd);
+    }
+
+    int poll (struct pollfd* fds, nfds_t numFds, int timeout)
+    {
+        check ("poll");
+        REALTIME_GUARD_NEXT (poll)
+        return next (fds, numFds, timeout);
+    }
+
+    int select (int numFds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds, struct timeval* timeout)
+    {
+        check ("select");
+        REALTIME_GUARD_NEXT (select)
+        return next (numFds, readFds, writeFds, exceptFds, timeout);
+    }
+
+    int nanosleep (const struct timespec* duration, struct timespec* remaining)
+    {
+        check ("nanosleep");
+        REALTIME_GUARD_NEXT (nanosleep)
+        return next (duration, remaining);
+    }
+
+    int clock_nanosleep (clockid_t clock, int flags, const struct timespec* time, struct timespec* remaining)
+    {
+        check ("clock_nanosleep");
+        REALTIME_GUARD_NEXT (clock_nanosleep)
+        return next (clock, flags, time, remaining);
+    }
+
+    int usleep (useconds_t microseconds)
+    {
+        check ("usleep");
+        REALTIME_GUARD_NEXT (usleep)
+        return next (microseconds);
+    }
+
+    int sched_yield() noexcept
+    {
+        check ("sched_yield");
+        REALTIME_GUARD_NEXT (sched_yield)
+        return next();
+    }
+
+    void* mmap (void* address, size_t length, int protection, int flags, int fd, off_t offset) noexcept
+    {
+        check ("mmap");
+        REALTIME_GUARD_NEXT (mmap)
+        return next (address, length, protection, flags, fd, offset);
+    }
+
+    int munmap (void* address, size_t length) noexcept
+    {
+        check ("munmap");
+        REALTIME_GUARD_NEXT (munmap)
+        return next (address, length);
+    }
+}
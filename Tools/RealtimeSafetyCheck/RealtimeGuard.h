@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+
+    Catches calls that don't belong on the audio thread. RealtimeGuard.cpp
+    defines malloc and friends, the pthread lock and wait functions and a set
+    of blocking system calls in the executable itself, so they take the place
+    of glibc's for everything linked into it, JUCE included. Each one checks
+    whether the calling thread is inside a ScopedAudioCallback and, if it is,
+    reports a violation with a stack trace before passing the call on.
+
+    Linux and glibc only: the allocator is reached through glibc's
+    __libc_malloc family, everything else through dlsym (RTLD_NEXT).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace RealtimeGuard
+{
+    /** Resolves the functions being wrapped and primes the stack trace code,
+        both of which allocate the first time. Call once before any audio
+        callback.
+    */
+    void initialise();
+
+    /** Marks the calling thread as running the audio callback until the
+        scope ends. Scopes can be nested. phase names what the driver was
+        doing, and is printed with any violation.
+    */
+    class ScopedAudioCallback
+    {
+    public:
+        explicit ScopedAudioCallback (const char* phase) noexcept;
+        ~ScopedAudioCallback() noexcept;
+
+        ScopedAudioCallback (const ScopedAudioCallback&) = delete;
+        ScopedAudioCallback& operator= (const ScopedAudioCallback&) = delete;
+
+    private:
+        const char* previousPhase;
+    };
+
+    /** By default the first maxReportedViolations violations are printed with
+        a stack trace and the rest are only counted. With this set the process
+        aborts on the first one instead, which suits running under a debugger.
+    */
+    void setAbortOnViolation (bool shouldAbort) noexcept;
+
+    constexpr int maxReportedViolations = 20;
+
+    /** The number of violations since the process started. */
+    int getNumViolations() noexcept;
+}
@@ -0,0 +1,33 @@
+# chorus_add_console_app(<target> <sources>...)
+#
+# A command-line program built around the plugin's processor. It compiles the
+# plugin sources along with its own, and links its own copy of the JUCE
+# modules, as the plugin's shared code target doesn't pass the module include
+# paths on.
+
+function(chorus_add_console_app target)
+    juce_add_console_app(${target} PRODUCT_NAME ${target})
+    juce_generate_juce_header(${target})
+
+    target_sources(${target} PRIVATE ${ARGN} ${CHORUS_PLUGIN_SOURCES})
+
+    # The plugin macros the processor reads, with the values the plugin has.
+    target_compile_definitions(${target}
+        PRIVATE
+            JucePlugin_Name="Chorus"
+            JucePlugin_IsSynth=0
+            JucePlugin_IsMidiEffect=0
+            JucePlugin_WantsMidiInput=0
+            JucePlugin_ProducesMidiOutput=0
+            JUCE_STRICT_REFCOUNTEDPOINTER=1
+            JUCE_WEB_BROWSER=0
+            JUCE_USE_CURL=0)
+
+    target_link_libraries(${target}
+        PRIVATE
+            ChorusDSP
+            juce::juce_audio_utils
+            juce::juce_dsp
+            juce::juce_recommended_config_flags
+            juce::juce_recommended_warning_flags)
+endfunction()
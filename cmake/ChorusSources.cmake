@@ -0,0 +1,30 @@
+# The plugin sources. Chorus/Chorus.jucer and Chorus_Windows/Chorus_Windows.jucer
+# list the same files, so a file added here has to go into both Projucer
+# projects as well.
+
+set(CHORUS_SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/../Chorus/Source")
+
+set(CHORUS_PLUGIN_SOURCES
+    ${CHORUS_SOURCE_DIR}/PluginProcessor.cpp
+    ${CHORUS_SOURCE_DIR}/PluginEditor.cpp
+    ${CHORUS_SOURCE_DIR}/AudioTracer.cpp
+    ${CHORUS_SOURCE_DIR}/ChannelThreadPool.cpp
+    ${CHORUS_SOURCE_DIR}/ChorusState.cpp
+    ${CHORUS_SOURCE_DIR}/EngineRebuilder.cpp
+    ${CHORUS_SOURCE_DIR}/FactoryPresets.cpp
+    ${CHORUS_SOURCE_DIR}/PresetBank.cpp
+    ${CHORUS_SOURCE_DIR}/SharedLfoClock.cpp)
+
+set(CHORUS_PLUGIN_HEADERS
+    ${CHORUS_SOURCE_DIR}/PluginProcessor.h
+    ${CHORUS_SOURCE_DIR}/PluginEditor.h
+    ${CHORUS_SOURCE_DIR}/AudioTracer.h
+    ${CHORUS_SOURCE_DIR}/ChannelThreadPool.h
+    ${CHORUS_SOURCE_DIR}/ChorusEngine.h
+    ${CHORUS_SOURCE_DIR}/ChorusState.h
+    ${CHORUS_SOURCE_DIR}/EngineRebuilder.h
+    ${CHORUS_SOURCE_DIR}/FactoryPresets.h
+    ${CHORUS_SOURCE_DIR}/LoadMonitor.h
+    ${CHORUS_SOURCE_DIR}/PresetBank.h
+    ${CHORUS_SOURCE_DIR}/QualityGovernor.h
+    ${CHORUS_SOURCE_DIR}/SharedLfoClock.h)